@@ -0,0 +1,46 @@
+#include <errno.h>
+#include <stddef.h>
+#include "alloc_trace.h"
+
+#ifdef ALLOC_TRACE
+// Bọc allocator của glibc: mọi cấp phát (kể cả operator new, cv::fastMalloc) đều đi qua đây
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t align, size_t size);
+}
+
+static __thread uint64_t thread_allocs = 0;
+
+extern "C" void* malloc(size_t size) {
+    thread_allocs++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+    thread_allocs++;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    thread_allocs++;
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" int posix_memalign(void** out, size_t align, size_t size) {
+    thread_allocs++;
+    void* p = __libc_memalign(align, size);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+uint64_t alloc_trace_thread_count() {
+    return thread_allocs;
+}
+#else
+uint64_t alloc_trace_thread_count() {
+    return 0;
+}
+#endif
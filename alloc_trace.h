@@ -0,0 +1,10 @@
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include <stdint.h>
+
+// Đếm số lần cấp phát heap (malloc/calloc/realloc/posix_memalign/new) của luồng hiện tại.
+// Chỉ hoạt động khi build với `make ALLOC_TRACE=1`, ngược lại luôn trả về 0.
+uint64_t alloc_trace_thread_count();
+
+#endif
@@ -0,0 +1,52 @@
+#include <atomic>
+#include "bcm2835_stub.h"
+
+// Luồng gửi SPI và luồng chính cùng ghi -> mọi bộ đếm là atomic
+static std::atomic<uint64_t> gpio_writes(0);
+static std::atomic<uint64_t> spi_calls(0);
+static std::atomic<uint64_t> spi_bytes(0);
+static std::atomic<uint64_t> delay_ms(0);
+
+int bcm2835_init(void) { return 1; }
+int bcm2835_close(void) { return 1; }
+void bcm2835_delay(unsigned int millis) { delay_ms += millis; }
+
+void bcm2835_gpio_fsel(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void bcm2835_gpio_write(uint8_t pin, uint8_t on) { (void)pin; (void)on; gpio_writes++; }
+
+int  bcm2835_spi_begin(void) { return 1; }
+void bcm2835_spi_end(void) {}
+void bcm2835_spi_setBitOrder(uint8_t order) { (void)order; }
+void bcm2835_spi_setDataMode(uint8_t mode) { (void)mode; }
+void bcm2835_spi_setClockDivider(uint16_t divider) { (void)divider; }
+void bcm2835_spi_chipSelect(uint8_t cs) { (void)cs; }
+void bcm2835_spi_setChipSelectPolarity(uint8_t cs, uint8_t active) { (void)cs; (void)active; }
+
+uint8_t bcm2835_spi_transfer(uint8_t value) {
+    (void)value;
+    spi_calls++;
+    spi_bytes++;
+    return 0;
+}
+
+void bcm2835_spi_transfern(char* buf, uint32_t len) {
+    // Chip thật ghi đè buf bằng dữ liệu MISO; LCD không trả gì -> 0
+    for (uint32_t i = 0; i < len; i++) buf[i] = 0;
+    spi_calls++;
+    spi_bytes += len;
+}
+
+void bcm2835_spi_writenb(const char* buf, uint32_t len) {
+    (void)buf;
+    spi_calls++;
+    spi_bytes += len;
+}
+
+Bcm2835StubStats bcm2835_stub_stats() {
+    Bcm2835StubStats st;
+    st.gpio_writes = gpio_writes.load();
+    st.spi_calls = spi_calls.load();
+    st.spi_bytes = spi_bytes.load();
+    st.delay_ms = delay_ms.load();
+    return st;
+}
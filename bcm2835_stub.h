@@ -0,0 +1,49 @@
+#ifndef BCM2835_STUB_H
+#define BCM2835_STUB_H
+
+#include <stdint.h>
+
+// Thay thư viện bcm2835 khi build HEADLESS (make replay): cùng tên hàm / hằng số đang dùng,
+// không đụng phần cứng, chỉ đếm những gì lẽ ra được gửi đi.
+#define HIGH 0x1
+#define LOW  0x0
+
+#define RPI_V2_GPIO_P1_16 23
+#define RPI_V2_GPIO_P1_18 24
+#define RPI_V2_GPIO_P1_22 25
+
+#define BCM2835_GPIO_FSEL_OUTP          0x01
+#define BCM2835_SPI_BIT_ORDER_MSBFIRST  1
+#define BCM2835_SPI_MODE0               0
+#define BCM2835_SPI_CLOCK_DIVIDER_8     8
+#define BCM2835_SPI_CS0                 0
+
+int  bcm2835_init(void);
+int  bcm2835_close(void);
+void bcm2835_delay(unsigned int millis);
+
+void bcm2835_gpio_fsel(uint8_t pin, uint8_t mode);
+void bcm2835_gpio_write(uint8_t pin, uint8_t on);
+
+int  bcm2835_spi_begin(void);
+void bcm2835_spi_end(void);
+void bcm2835_spi_setBitOrder(uint8_t order);
+void bcm2835_spi_setDataMode(uint8_t mode);
+void bcm2835_spi_setClockDivider(uint16_t divider);
+void bcm2835_spi_chipSelect(uint8_t cs);
+void bcm2835_spi_setChipSelectPolarity(uint8_t cs, uint8_t active);
+uint8_t bcm2835_spi_transfer(uint8_t value);
+void bcm2835_spi_transfern(char* buf, uint32_t len);
+void bcm2835_spi_writenb(const char* buf, uint32_t len);
+
+// Thống kê những gì lẽ ra đã ra chân GPIO / SPI (bản chụp tại lúc gọi bcm2835_stub_stats)
+typedef struct {
+    uint64_t gpio_writes;
+    uint64_t spi_calls;
+    uint64_t spi_bytes;
+    uint64_t delay_ms;      // Tổng thời gian delay được yêu cầu (không ngủ thật)
+} Bcm2835StubStats;
+
+Bcm2835StubStats bcm2835_stub_stats();
+
+#endif
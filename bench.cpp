@@ -0,0 +1,366 @@
+// Benchmark các kernel nóng của pipeline, không cần Pi / LCD / camera / model.
+//   make bench
+//   ./microbench [lọc theo tên] > bench.jsonl
+// Mỗi case in 1 dòng JSON: ns/op (trung vị BENCH_REPEAT lần đo) và MB/s theo số byte đầu vào mỗi op,
+// để so sánh giữa các commit hoặc giữa Pi 3 / Pi 4.
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/utsname.h>
+#include <algorithm>
+#include <vector>
+#include "config.h"
+#include "rgb565.h"
+#include "facenet.h"
+#include "face_preprocess.h"
+#include "face_quality.h"
+#include "face_gallery.h"
+#include "detection_filter.h"
+#include "frame_pool.h"
+#include "queue_helper.h"
+#include "mjpeg_decoder.h"
+#include "lcd_overlay.h"
+
+#define BENCH_MIN_NS    200000000ULL    // Mỗi lần đo chạy ít nhất 200 ms
+#define BENCH_REPEAT    5
+#define BENCH_FACE_SIZE 100             // Cạnh ROI khuôn mặt (cỡ mặt điển hình ở 320x240)
+#define BENCH_EMB_DIM   128
+#define BENCH_GALLERY   10000
+
+// Định nghĩa cho các biến extern (bench không link main.cpp)
+FramePool frame_pool;
+FrameQueue q_display;
+
+static const char* filter = NULL;
+
+static bool selected(const char* name) {
+    return !filter || strstr(name, filter);
+}
+
+// fn(iters) chạy đúng iters op. Tăng iters tới khi 1 lần đo đủ dài (cũng là lượt chạy làm nóng)
+template <typename F>
+static uint64_t bench_calibrate(F fn) {
+    uint64_t iters = 1;
+    while (1) {
+        uint64_t t0 = frame_clock_ns();
+        fn(iters);
+        uint64_t ns = frame_clock_ns() - t0;
+        if (ns >= BENCH_MIN_NS / 4) return std::max<uint64_t>(1, (uint64_t)((double)iters * BENCH_MIN_NS / ns));
+        iters *= 2;
+    }
+}
+
+// BENCH_REPEAT lần đo, ns/op tăng dần
+template <typename F>
+static void bench_time(F fn, uint64_t iters, std::vector<double>& ns_op) {
+    ns_op.clear();
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        uint64_t t0 = frame_clock_ns();
+        fn(iters);
+        ns_op.push_back((double)(frame_clock_ns() - t0) / iters);
+    }
+    std::sort(ns_op.begin(), ns_op.end());
+}
+
+static void bench_print(const char* name, double bytes_per_op, uint64_t iters,
+                        const std::vector<double>& ns_op, const char* note) {
+    double med = ns_op[BENCH_REPEAT / 2];
+    printf("{\"name\":\"%s\",\"ns_per_op\":%.1f,\"mb_per_s\":%.1f,\"bytes_per_op\":%.0f,"
+           "\"iters\":%llu,\"min_ns\":%.1f,\"max_ns\":%.1f",
+           name, med, bytes_per_op > 0 ? bytes_per_op * 1e3 / med : 0.0, bytes_per_op,
+           (unsigned long long)iters, ns_op.front(), ns_op.back());
+    if (note) printf(",\"note\":\"%s\"", note);
+    printf("}\n");
+    fflush(stdout);
+}
+
+// Đo rồi in trung vị
+template <typename F>
+static void bench(const char* name, double bytes_per_op, F fn, const char* note = NULL) {
+    if (!selected(name)) return;
+    uint64_t iters = bench_calibrate(fn);
+    std::vector<double> ns_op;
+    bench_time(fn, iters, ns_op);
+    bench_print(name, bytes_per_op, iters, ns_op, note);
+}
+
+// Chống compiler bỏ phép tính không dùng kết quả
+static volatile float sink;
+
+// --- QUEUE: 1 producer đẩy handle, 1 consumer lấy ra (giống Camera -> LCD) ---
+// Bản mutex + condvar (cách làm trước khi có queue lock-free) để so sánh, cùng luật bỏ frame cũ nhất
+typedef struct {
+    FrameHandle frames[QUEUE_SIZE];
+    int head, count, closed;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} MutexQueue;
+
+static void mq_push(MutexQueue* q, const FrameHandle& f) {
+    pthread_mutex_lock(&q->mutex);
+    if (q->count == QUEUE_SIZE) {
+        q->frames[q->head].reset();
+        q->head = (q->head + 1) % QUEUE_SIZE;
+        q->count--;
+    }
+    q->frames[(q->head + q->count) % QUEUE_SIZE] = f;
+    q->count++;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+static int mq_pop(MutexQueue* q, FrameHandle* out) {
+    pthread_mutex_lock(&q->mutex);
+    while (q->count == 0 && !q->closed) pthread_cond_wait(&q->cond, &q->mutex);
+    int ok = q->count > 0;
+    if (ok) {
+        *out = std::move(q->frames[q->head]);
+        q->head = (q->head + 1) % QUEUE_SIZE;
+        q->count--;
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return ok;
+}
+
+static uint64_t queue_popped;
+
+static void* spsc_consumer(void* arg) {
+    FrameQueue* q = (FrameQueue*)arg;
+    FrameHandle h;
+    while (queue_pop(q, &h)) {
+        queue_popped++;
+        h.reset();
+    }
+    return NULL;
+}
+
+static void* mutex_consumer(void* arg) {
+    MutexQueue* q = (MutexQueue*)arg;
+    FrameHandle h;
+    while (mq_pop(q, &h)) {
+        queue_popped++;
+        h.reset();
+    }
+    return NULL;
+}
+
+static void run_queue_spsc(uint64_t iters) {
+    static FrameQueue q;
+    queue_init(&q);
+    FrameHandle frame = frame_pool_acquire(&frame_pool);
+    queue_popped = 0;
+
+    pthread_t t;
+    pthread_create(&t, NULL, spsc_consumer, &q);
+    for (uint64_t i = 0; i < iters; i++) queue_push(&q, frame);
+    queue_close(&q);
+    pthread_join(t, NULL);
+}
+
+static void run_queue_mutex(uint64_t iters) {
+    static MutexQueue q;
+    q.head = q.count = q.closed = 0;
+    pthread_mutex_init(&q.mutex, NULL);
+    pthread_cond_init(&q.cond, NULL);
+    FrameHandle frame = frame_pool_acquire(&frame_pool);
+    queue_popped = 0;
+
+    pthread_t t;
+    pthread_create(&t, NULL, mutex_consumer, &q);
+    for (uint64_t i = 0; i < iters; i++) mq_push(&q, frame);
+    pthread_mutex_lock(&q.mutex);
+    q.closed = 1;
+    pthread_cond_signal(&q.cond);
+    pthread_mutex_unlock(&q.mutex);
+    pthread_join(t, NULL);
+    pthread_mutex_destroy(&q.mutex);
+    pthread_cond_destroy(&q.cond);
+}
+
+// Hàng đợi đầy thì producer bỏ frame cũ nhất -> MB/s quy đổi theo số frame consumer thực sự nhận được,
+// cộng dồn trong chính các lần đo (không lấy từ 1 lượt chạy riêng)
+static void bench_queue(const char* name, void (*run)(uint64_t), double frame_bytes) {
+    if (!selected(name)) return;
+    uint64_t iters = bench_calibrate(run);
+    uint64_t popped = 0;
+    std::vector<double> ns_op;
+    bench_time([&](uint64_t n) {
+        run(n);
+        popped += queue_popped;
+    }, iters, ns_op);
+
+    double pushed = (double)iters * BENCH_REPEAT;
+    char note[64];
+    snprintf(note, sizeof(note), "delivered %.0f%%", 100.0 * popped / pushed);
+    bench_print(name, frame_bytes * popped / pushed, iters, ns_op, note);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) filter = argv[1];
+    cv::setNumThreads(1);           // Đo 1 luồng như trong pipeline
+
+    struct utsname u;
+    uname(&u);
+    printf("{\"name\":\"meta\",\"machine\":\"%s\",\"rgb565_kernel\":\"%s\",\"gallery_kernel\":\"%s\"}\n",
+           u.machine, rgb565_kernel_name(), FaceGallery::kernelName());
+
+    // Dữ liệu cố định (seed cố định) để các lần chạy so sánh được với nhau
+    cv::RNG rng(12345);
+    cv::Mat frame(LCD_HEIGHT, LCD_WIDTH, CV_8UC3);
+    rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(frame, frame, cv::Size(5, 5), 0);     // Gần ảnh thật hơn nhiễu trắng
+    cv::Mat gray;
+    cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    cv::Rect roi((LCD_WIDTH - BENCH_FACE_SIZE) / 2, (LCD_HEIGHT - BENCH_FACE_SIZE) / 2,
+                 BENCH_FACE_SIZE, BENCH_FACE_SIZE);
+    cv::Mat face = frame(roi);
+    cv::Mat face_gray = gray(roi);
+    size_t pixels = (size_t)LCD_WIDTH * LCD_HEIGHT;
+    size_t face_bytes = (size_t)BENCH_FACE_SIZE * BENCH_FACE_SIZE * 3;
+
+    // --- BGR -> RGB565 (task_lcd) ---
+    std::vector<uint8_t> spi_buffer(pixels * 2);
+    bench("rgb565", pixels * 3, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) bgr_to_rgb565(frame.data, spi_buffer.data(), pixels);
+    }, rgb565_kernel_name());
+    bench("rgb565_scalar", pixels * 3, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) bgr_to_rgb565_scalar(frame.data, spi_buffer.data(), pixels);
+    });
+
+    // --- YUYV (CAMERA_BACKEND=v4l2): 1 lượt thẳng sang RGB565 vs qua BGR như đường OpenCV ---
+    cv::Mat yuyv(LCD_HEIGHT, LCD_WIDTH, CV_8UC2);
+    rng.fill(yuyv, cv::RNG::UNIFORM, 0, 256);
+    cv::Mat yuyv_bgr;
+    bench("yuyv_rgb565", pixels * 2, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) yuyv_to_rgb565(yuyv.data, spi_buffer.data(), pixels);
+    });
+    bench("yuyv_bgr_rgb565", pixels * 2, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            cv::cvtColor(yuyv, yuyv_bgr, cv::COLOR_YUV2BGR_YUYV);
+            bgr_to_rgb565(yuyv_bgr.data, spi_buffer.data(), pixels);
+        }
+    });
+
+    // --- UI của task_lcd (1 box + 1 dòng message): overlay RGB565 vs copy frame + vẽ OpenCV trên BGR + convert ---
+    LcdOverlay overlay;
+    lcd_overlay_init(&overlay);
+    const char* message = "ACCESS GRANTED: User 1";
+    cv::Rect box(100, 60, 120, 120);
+    uint16_t color = rgb565_be_pixel(0, 255, 0);
+    bench("overlay_rgb565", 0, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            lcd_overlay_begin(&overlay);
+            lcd_overlay_rect(&overlay, spi_buffer.data(), box.x, box.y, box.width, box.height, color, 2);
+            lcd_overlay_text(&overlay, spi_buffer.data(), message, box.x, box.y - 10, OVERLAY_FONT_MESSAGE, color);
+        }
+    });
+    cv::Mat ui_frame(LCD_HEIGHT, LCD_WIDTH, CV_8UC3);
+    bench("overlay_opencv_bgr", 0, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            frame.copyTo(ui_frame);
+            cv::rectangle(ui_frame, box, cv::Scalar(0, 255, 0), 2);
+            cv::putText(ui_frame, message, cv::Point(box.x, box.y - 10), cv::FONT_HERSHEY_SIMPLEX, 0.6,
+                        cv::Scalar(0, 255, 0), 2);
+        }
+    }, "copy + rectangle + putText, before rgb565");
+    lcd_overlay_free(&overlay);
+
+    // --- MJPEG 640x480 (CAMERA_BACKEND=mjpeg): IDCT 1/2 thẳng ra 320x240 vs decode full + resize ---
+    cv::Mat cam_full;
+    cv::resize(frame, cam_full, cv::Size(MJPEG_CAPTURE_W, MJPEG_CAPTURE_H));
+    std::vector<uint8_t> jpeg_buf;
+    cv::imencode(".jpg", cam_full, jpeg_buf);
+    cv::Mat jpeg_mat(1, (int)jpeg_buf.size(), CV_8UC1, jpeg_buf.data());
+    cv::Mat decoded(LCD_HEIGHT, LCD_WIDTH, CV_8UC3);
+    MjpegDecoder jpeg;
+    mjpeg_decoder_init(&jpeg);
+    bench("mjpeg_scaled", (double)jpeg_buf.size(), [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            mjpeg_decode(&jpeg, jpeg_buf.data(), jpeg_buf.size(), decoded.data, decoded.cols, decoded.rows, decoded.step);
+        }
+    });
+    bench("mjpeg_imdecode_resize", (double)jpeg_buf.size(), [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            cv::imdecode(jpeg_mat, cv::IMREAD_COLOR, &cam_full);
+            cv::resize(cam_full, decoded, cv::Size(LCD_WIDTH, LCD_HEIGHT));
+        }
+    });
+    mjpeg_decoder_free(&jpeg);
+
+    // --- Tiền xử lý FaceNet: bản tham chiếu vs kernel gộp ---
+    std::vector<float> blob(3 * FACE_INPUT_SIZE * FACE_INPUT_SIZE);
+    bench("preprocess_standard", face_bytes, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            cv::Mat m = FaceNet::preprocessFaceStandard(face);
+            sink = m.ptr<float>(0)[0];
+        }
+    });
+    bench("preprocess_fused", face_bytes, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            face_preprocess_fused(face.data, face.cols, face.rows, face.step, blob.data());
+        }
+        sink = blob[0];
+    });
+
+    // --- Điểm chất lượng: assessFaceQuality (BGR, nhiều lượt) vs 1 lượt trên ảnh xám ---
+    FaceNet net;                    // Không cần nạp model cho quality / cosine
+    bench("quality_reference", face_bytes, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) sink = net.checkQuality(face);
+    });
+    bench("quality_gray", (double)BENCH_FACE_SIZE * BENCH_FACE_SIZE, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            sink = face_quality_gray(face_gray.data, face_gray.cols, face_gray.rows, face_gray.step);
+        }
+    });
+
+    // --- So khớp embedding ---
+    cv::Mat e1(1, BENCH_EMB_DIM, CV_32F), e2(1, BENCH_EMB_DIM, CV_32F);
+    rng.fill(e1, cv::RNG::NORMAL, 0, 1);
+    rng.fill(e2, cv::RNG::NORMAL, 0, 1);
+    cv::normalize(e1, e1);          // Embedding thật luôn đã L2 normalize
+    cv::normalize(e2, e2);
+    bench("cosine_similarity", 2.0 * BENCH_EMB_DIM * sizeof(float), [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) sink = net.cosineSimilarity(e1, e2);
+    });
+
+    if (selected("gallery_search_10k") || selected("gallery_search_10k_int8")) {
+        FaceGallery gallery;
+        gallery.init(BENCH_EMB_DIM);
+        cv::Mat e(1, BENCH_EMB_DIM, CV_32F);
+        char name[GALLERY_NAME_LEN];
+        for (int i = 0; i < BENCH_GALLERY; i++) {
+            rng.fill(e, cv::RNG::NORMAL, 0, 1);
+            snprintf(name, sizeof(name), "id%d", i);
+            gallery.add(name, e.ptr<float>());
+        }
+        GalleryMatch top[5];
+        double gallery_bytes = (double)BENCH_GALLERY * BENCH_EMB_DIM * sizeof(float);
+        bench("gallery_search_10k", gallery_bytes, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) gallery.search(e1.ptr<float>(), 5, top);
+            sink = top[0].score;
+        });
+        gallery.setInt8(true);
+        bench("gallery_search_10k_int8", (double)BENCH_GALLERY * BENCH_EMB_DIM, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) gallery.search(e1.ptr<float>(), 5, top);
+            sink = top[0].score;
+        });
+    }
+
+    // --- Bộ lọc kết quả: 1 op = 1 frame đưa similarity mới vào ---
+    DetectionFilter filter_state;
+    float sims[16];
+    for (int i = 0; i < 16; i++) sims[i] = 0.7f + rng.uniform(-0.05f, 0.05f);
+    bench("detection_filter_is_stable", sizeof(float), [&](uint64_t n) {
+        int stable = 0;
+        for (uint64_t i = 0; i < n; i++) stable += filter_state.isStable(sims[i & 15]);
+        sink = (float)stable;
+    });
+
+    // --- Hàng đợi Camera -> LCD giữa 2 luồng: 1 op = 1 lần push (đầy thì bỏ frame cũ nhất) ---
+    // MB/s quy đổi theo số frame 320x240 consumer thực sự nhận được
+    if (!selected("queue_spsc") && !selected("queue_mutex")) return 0;
+    frame_pool_init(&frame_pool);
+    bench_queue("queue_spsc", run_queue_spsc, (double)pixels * 3);
+    bench_queue("queue_mutex", run_queue_mutex, (double)pixels * 3);
+    return 0;
+}
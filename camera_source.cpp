@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include "camera_source.h"
+#include "frame_pool.h"
+
+static int open_video(CameraSource* s) {
+    s->cap.release();
+    if (!s->cap.open(s->path)) return 0;
+    double fps = s->cap.get(cv::CAP_PROP_FPS);
+    if (fps <= 0.0 || fps > 240.0) fps = REPLAY_DEFAULT_FPS;   // Container không ghi FPS
+    s->period_ns = (uint64_t)(1e9 / fps);
+    return 1;
+}
+
+int camera_source_open(CameraSource* s, const char* spec, int throttle, int loop) {
+    s->path = spec ? spec : "";
+    s->files.clear();
+    s->next_file = 0;
+    s->throttle = throttle;
+    s->loop = loop;
+    s->period_ns = (uint64_t)(1e9 / REPLAY_DEFAULT_FPS);
+    s->next_ns = 0;
+    s->frames = 0;
+
+    if (s->path.empty()) {
+        // Mở Camera (Ưu tiên V4L2 trên Linux/Pi)
+        s->kind = CAMERA_SOURCE_LIVE;
+        s->throttle = 0;            // Camera tự giữ nhịp
+        s->loop = 0;
+        if (!s->cap.open(0, cv::CAP_V4L2)) return 0;
+
+        // Cấu hình cứng độ phân giải khớp với LCD để không phải resize
+        s->cap.set(cv::CAP_PROP_FRAME_WIDTH, LCD_WIDTH);  // 320
+        s->cap.set(cv::CAP_PROP_FRAME_HEIGHT, LCD_HEIGHT); // 240
+        s->cap.set(cv::CAP_PROP_FPS, 30);
+        return s->cap.isOpened();
+    }
+
+    struct stat st;
+    if (stat(s->path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        s->kind = CAMERA_SOURCE_IMAGES;
+        std::vector<cv::String> more;
+        cv::glob(s->path + "/*.jpg", s->files, false);
+        cv::glob(s->path + "/*.png", more, false);
+        s->files.insert(s->files.end(), more.begin(), more.end());
+        std::sort(s->files.begin(), s->files.end());
+        return !s->files.empty();
+    }
+
+    s->kind = CAMERA_SOURCE_VIDEO;
+    return open_video(s);
+}
+
+int camera_source_open_v4l2(CameraSource* s, const char* device, uint32_t pixfmt, int loop) {
+    s->kind = CAMERA_SOURCE_V4L2;
+    s->path = device;
+    s->files.clear();
+    s->next_file = 0;
+    s->period_ns = (uint64_t)(1e9 / CAMERA_FPS);
+    s->next_ns = 0;
+    s->frames = 0;
+    int mjpeg = pixfmt == V4L2_PIX_FMT_MJPEG;
+    if (!v4l2_capture_open(&s->v4l2, device, mjpeg ? MJPEG_CAPTURE_W : LCD_WIDTH,
+                           mjpeg ? MJPEG_CAPTURE_H : LCD_HEIGHT, CAMERA_FPS, pixfmt)) return 0;
+
+    // Không resize YUYV: driver phải cho đúng kích thước LCD
+    if (!mjpeg && (s->v4l2.width != LCD_WIDTH || s->v4l2.height != LCD_HEIGHT)) {
+        printf("[V4L2] %s: driver gave %dx%d, need %dx%d\n", device,
+               s->v4l2.width, s->v4l2.height, LCD_WIDTH, LCD_HEIGHT);
+        v4l2_capture_close(&s->v4l2);
+        return 0;
+    }
+    // File giả thì tự giữ nhịp như camera
+    s->throttle = s->v4l2.fake;
+    s->loop = s->v4l2.fake && loop;
+    return 1;
+}
+
+static int read_v4l2(CameraSource* s, cv::Mat& frame) {
+    const uint8_t* data;
+    size_t size;
+    int r = v4l2_capture_next(&s->v4l2, &data, &size, 100);
+    if (r == 0 && s->loop) {
+        v4l2_capture_rewind(&s->v4l2);
+        r = v4l2_capture_next(&s->v4l2, &data, &size, 100);
+    }
+    if (r <= 0) return r;
+    if (s->v4l2.pixfmt == V4L2_PIX_FMT_MJPEG) {
+        frame = cv::Mat(1, (int)size, CV_8UC1, (void*)data);
+    } else {
+        frame = cv::Mat(s->v4l2.height, s->v4l2.width, CV_8UC2, (void*)data, s->v4l2.stride);
+    }
+    return 1;
+}
+
+static int read_next(CameraSource* s, cv::Mat& frame) {
+    if (s->kind == CAMERA_SOURCE_V4L2) return read_v4l2(s, frame);
+    if (s->kind == CAMERA_SOURCE_IMAGES) {
+        // Bỏ qua ảnh hỏng, tối đa 1 vòng
+        for (size_t tries = 0; tries < s->files.size(); tries++) {
+            if (s->next_file >= s->files.size()) {
+                if (!s->loop) return 0;
+                s->next_file = 0;
+            }
+            frame = cv::imread(s->files[s->next_file++], cv::IMREAD_COLOR);
+            if (!frame.empty()) return 1;
+        }
+        return 0;
+    }
+
+    s->cap >> frame;
+    if (!frame.empty()) return 1;
+    if (s->kind == CAMERA_SOURCE_LIVE) return -1;
+
+    // Hết file video: mở lại từ đầu (CAP_PROP_POS_FRAMES không tin được với mọi backend)
+    if (!s->loop || !open_video(s)) return 0;
+    s->cap >> frame;
+    return frame.empty() ? 0 : 1;
+}
+
+int camera_source_read(CameraSource* s, cv::Mat& frame) {
+    int r = read_next(s, frame);
+    if (r <= 0) return r;
+
+    if (s->throttle) {
+        // Giữ nhịp theo lịch cố định, không cộng dồn sai lệch của từng lần sleep
+        uint64_t now = frame_clock_ns();
+        if (s->next_ns == 0 || s->next_ns + s->period_ns < now) s->next_ns = now;  // Tụt lại -> không dồn frame
+        if (s->next_ns > now) {
+            uint64_t wait = s->next_ns - now;
+            struct timespec ts = { (time_t)(wait / 1000000000ULL), (long)(wait % 1000000000ULL) };
+            nanosleep(&ts, NULL);
+        }
+        s->next_ns += s->period_ns;
+    }
+    s->frames++;
+    return 1;
+}
+
+CameraFormat camera_source_format(const CameraSource* s) {
+    if (s->kind != CAMERA_SOURCE_V4L2) return CAMERA_FORMAT_BGR;
+    return s->v4l2.pixfmt == V4L2_PIX_FMT_MJPEG ? CAMERA_FORMAT_MJPEG : CAMERA_FORMAT_YUYV;
+}
+
+void camera_source_close(CameraSource* s) {
+    if (s->kind == CAMERA_SOURCE_V4L2) v4l2_capture_close(&s->v4l2);
+    s->cap.release();
+    s->files.clear();
+}
@@ -0,0 +1,57 @@
+#ifndef CAMERA_SOURCE_H
+#define CAMERA_SOURCE_H
+
+#include <opencv4/opencv2/opencv.hpp>
+#include <vector>
+#include <stdint.h>
+#include "config.h"
+#include "v4l2_capture.h"
+
+// Nguồn frame cho Task Camera:
+//   - Camera thật (/dev/video0, V4L2) qua cv::VideoCapture -> BGR
+//   - Camera thật qua V4L2 mmap trực tiếp: CAMERA_BACKEND=v4l2 -> YUYV, CAMERA_BACKEND=mjpeg -> JPEG
+//     chưa giải nén (task_camera tự decode thu nhỏ vào frame pool); hoặc file YUYV / MJPEG giả làm camera
+//   - File video (REPLAY_SOURCE=clip.mp4)
+//   - Thư mục ảnh jpg/png, đọc theo thứ tự tên (REPLAY_SOURCE=frames/)
+// Replay có 2 tốc độ: native (giữ FPS gốc, giống camera) hoặc max (không chờ, để benchmark)
+enum CameraSourceKind {
+    CAMERA_SOURCE_LIVE = 0,
+    CAMERA_SOURCE_VIDEO,
+    CAMERA_SOURCE_IMAGES,
+    CAMERA_SOURCE_V4L2,             // Frame trỏ thẳng vào buffer mmap
+};
+
+// Nội dung frame camera_source_read trả về
+enum CameraFormat {
+    CAMERA_FORMAT_BGR = 0,          // CV_8UC3, kích thước tùy nguồn
+    CAMERA_FORMAT_YUYV,             // CV_8UC2 LCD_WIDTH x LCD_HEIGHT
+    CAMERA_FORMAT_MJPEG,            // CV_8UC1 1 x N: 1 ảnh JPEG
+};
+
+typedef struct {
+    CameraSourceKind kind;
+    std::string path;
+    cv::VideoCapture cap;
+    std::vector<cv::String> files;  // CAMERA_SOURCE_IMAGES
+    size_t next_file;
+    V4l2Capture v4l2;               // CAMERA_SOURCE_V4L2
+    int throttle;                   // 1 = giữ FPS gốc
+    int loop;                       // 1 = hết nguồn thì đọc lại từ đầu
+    uint64_t period_ns;             // Khoảng cách giữa 2 frame ở FPS gốc
+    uint64_t next_ns;               // Thời điểm được trả frame tiếp theo
+    uint64_t frames;                // Số frame đã trả
+} CameraSource;
+
+// spec = NULL/"" -> camera thật. Trả về 1 nếu mở được
+int  camera_source_open(CameraSource* s, const char* spec, int throttle, int loop);
+// V4L2 mmap. YUYV: đúng LCD_WIDTH x LCD_HEIGHT (driver không cho kích thước này -> trả về 0).
+// MJPEG: xin MJPEG_CAPTURE_W x MJPEG_CAPTURE_H, kích thước nào cũng nhận.
+// device là file thường -> đọc frame YUYV thô / MJPEG, giữ CAMERA_FPS và đọc vòng nếu loop
+int  camera_source_open_v4l2(CameraSource* s, const char* device, uint32_t pixfmt, int loop);
+// 1 = có frame, 0 = hết nguồn (replay không loop), -1 = tạm chưa có frame (camera thật).
+// CAMERA_SOURCE_V4L2: frame chỉ hợp lệ tới lần đọc sau (buffer trả lại cho driver)
+int  camera_source_read(CameraSource* s, cv::Mat& frame);
+CameraFormat camera_source_format(const CameraSource* s);
+void camera_source_close(CameraSource* s);
+
+#endif
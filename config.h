@@ -1,7 +1,12 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// make replay: build không cần Pi (bcm2835 giả, LCD giả lập trong RAM)
+#ifdef HEADLESS
+#include "bcm2835_stub.h"
+#else
 #include <bcm2835.h>
+#endif
 
 // --- CẤU HÌNH PIN ---
 #define PIN_DC     RPI_V2_GPIO_P1_22 // GPIO 25
@@ -12,7 +17,75 @@
 #define LCD_WIDTH  320
 #define LCD_HEIGHT 240
 
+// --- CẤU HÌNH SPI LCD (LCD_TRANSPORT=bcm2835|spidev, LCD_SPIDEV=/dev/spidevB.C, LCD_SPI_HZ=N) ---
+#define LCD_TRANSPORT_DEFAULT "bcm2835"
+#define LCD_SPIDEV_DEFAULT    "/dev/spidev0.0"
+#define LCD_SPI_HZ            32000000  // ~ CLOCK_DIVIDER_8 của bcm2835 trên Pi 3 (core 250 MHz)
+#define LCD_SPIDEV_CHUNK      65536     // Byte mỗi transfer spidev (bị giới hạn thêm bởi spidev.bufsiz)
+
+// --- CẤU HÌNH CẬP NHẬT LCD THEO TILE (DELTA) ---
+#define LCD_DELTA_UPDATE   1    // 0 = luôn gửi cả frame
+#define LCD_TILE_W         32   // 320 / 32 = 10 tile mỗi hàng
+#define LCD_TILE_H         16   // 240 / 16 = 15 hàng tile
+#define LCD_TILE_THRESHOLD 2    // Sai khác TB mỗi pixel (|dR|+|dG|+|dB| theo đơn vị 565) để tile bị coi là đổi
+#define LCD_FULL_REFRESH   300  // Cứ N frame gửi lại full 1 lần (chống lệch tích lũy)
+#define LCD_STATS_INTERVAL 100  // In thống kê sau mỗi N frame
+
 // --- CẤU HÌNH QUEUE ---
 #define QUEUE_SIZE 2
+#define QUEUE_SLOTS 4   // Slot cấp phát sẵn: lũy thừa của 2, > QUEUE_SIZE (dư 1 slot cho consumer đang đọc)
+
+// --- CẤU HÌNH PIPELINE AI (DETECT -> RECOGNIZE) ---
+#define AI_DETECT_THREADS 1     // Luồng stage Detect (mỗi luồng 1 detector + tracker riêng)
+#define AI_RECOG_THREADS  1     // Luồng stage Recognize (mỗi luồng 1 FaceNet riêng)
+#define AI_HANDOFF_SIZE   2     // Số job tối đa chờ giữa 2 stage
+// AI_WAIT=event|poll: poll = cách lấy frame cũ (kiểm tra mỗi 10 ms, ngủ 5 ms sau mỗi frame)
+// để đo capture->result trước / sau khi chuyển sang đánh thức bằng condvar
+#define AI_WAIT_DEFAULT   "event"
+#define AI_POLL_US        10000
+#define AI_POLL_AFTER_US  5000
+
+// --- CẤU HÌNH FRAME POOL ---
+// Camera 1 + Queue QUEUE_SLOTS + LCD 1 + AI (ai_channel 1 + mỗi luồng Detect/Recognize 1 + job đang chờ)
+#define FRAME_POOL_SIZE (QUEUE_SLOTS + 3 + AI_DETECT_THREADS + AI_HANDOFF_SIZE + AI_RECOG_THREADS)
+
+// --- CẤU HÌNH MODEL / LƯU TRỮ ---
+#define FACENET_MODEL_PATH   "MobileFaceNet.onnx"
+#define FACENET_MODEL_INT8_PATH "MobileFaceNet_int8.onnx"   // FACENET_INT8=1: bản lượng tử hóa INT8 (QDQ)
+#define EMBEDDING_STORE_PATH "embeddings.bin"   // Danh tính đã đăng ký (tự nạp khi khởi động)
+
+// --- CẤU HÌNH GALLERY NHẬN DIỆN ---
+#define GALLERY_INT8 0  // 1 = quét bằng bản sao int8 rồi tính lại top ứng viên bằng float32 (gallery lớn)
+
+// --- CẤU HÌNH BỘ PHÁT HIỆN KHUÔN MẶT ---
+// Chọn lúc chạy: FACE_DETECTOR=haar|dnn ./app_camera (mặc định DETECTOR_DEFAULT)
+#define DETECTOR_DEFAULT   "haar"
+#define DETECTOR_HAAR_SCALE   0.5  // Haar quét trên ảnh thu nhỏ (1.0 = độ phân giải gốc, kết quả y như cũ)
+#define DETECTOR_HAAR_THREADS 3    // Số luồng chia dải scale (kể cả luồng AI), chừa 1 core cho Camera/LCD
+#define DETECTOR_DNN_MODEL "face_detection_yunet_2023mar.onnx"
+#define DETECTOR_DNN_W     160    // Kích thước ảnh đưa vào mạng (thu nhỏ từ 320x240)
+#define DETECTOR_DNN_H     120
+#define DETECTOR_DNN_SCORE 0.7f   // Ngưỡng confidence
+#define DETECTOR_DNN_NMS   0.3f   // Ngưỡng IoU cho NMS
+
+// --- CẤU HÌNH BÁM KHUÔN MẶT (DETECT-THEN-TRACK) ---
+#define TRACK_ENABLE        1     // 0 = chạy Haar mọi frame
+#define TRACK_MAX_FRAMES    10    // Detect lại sau tối đa N frame bám
+#define TRACK_MIN_SCORE     0.6f  // NCC thấp hơn ngưỡng -> mất dấu, detect lại ngay
+#define TRACK_SEARCH_MARGIN 0.5   // Vùng tìm = box cũ nới mỗi phía 0.5 lần kích thước
+#define TRACK_TEMPLATE_SIZE 32    // Cạnh dài template sau khi thu nhỏ (pixel)
+#define AI_STATS_INTERVAL   50    // In latency AI + tỉ lệ detect/track sau mỗi N frame
+#define STATS_INTERVAL_S    10    // Chu kỳ dump histogram các stage vào STATS_FILE (giây)
+
+// --- CAMERA (CAMERA_BACKEND=opencv|v4l2|mjpeg, CAMERA_DEVICE=/dev/videoN) ---
+#define CAMERA_BACKEND_DEFAULT "opencv"      // v4l2 = YUYV mmap trực tiếp, không decode / resize
+#define CAMERA_DEVICE_DEFAULT  "/dev/video0"
+#define CAMERA_FPS             30
+#define V4L2_BUFFERS           4             // Buffer mmap xoay vòng với driver
+#define MJPEG_CAPTURE_W        640           // mjpeg: xin 640x480, IDCT 1/2 ra đúng 320x240
+#define MJPEG_CAPTURE_H        480
+
+// --- REPLAY (REPLAY_SOURCE=video|thư mục ảnh, REPLAY_RATE=native|max, REPLAY_FRAMES=N) ---
+#define REPLAY_DEFAULT_FPS  30    // FPS khi nguồn không cho biết (thư mục ảnh, video thiếu metadata)
 
 #endif
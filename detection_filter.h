@@ -0,0 +1,48 @@
+#ifndef DETECTION_FILTER_H
+#define DETECTION_FILTER_H
+
+#include <math.h>
+#include <vector>
+
+// Bộ lọc kết quả: chỉ tin similarity khi các frame gần nhất ổn định (tách ra để benchmark riêng)
+struct DetectionFilter {
+    std::vector<float> recent_similarities;
+    const int WINDOW_SIZE = 7;  // Tăng lên 7 frame
+    
+    bool isStable(float new_similarity) {
+        recent_similarities.push_back(new_similarity);
+        if (recent_similarities.size() > (size_t)WINDOW_SIZE) {
+            recent_similarities.erase(recent_similarities.begin());
+        }
+        
+        if (recent_similarities.size() < 5) return false;
+        
+        // Tính độ lệch chuẩn
+        float mean = 0;
+        for (float s : recent_similarities) mean += s;
+        mean /= recent_similarities.size();
+        
+        float variance = 0;
+        for (float s : recent_similarities) {
+            variance += (s - mean) * (s - mean);
+        }
+        variance /= recent_similarities.size();
+        float stddev = sqrt(variance);
+        
+        // Ổn định nếu stddev < 0.05
+        return stddev < 0.05f;
+    }
+    
+    float getAverage() {
+        if (recent_similarities.empty()) return 0.0f;
+        float sum = 0;
+        for (float s : recent_similarities) sum += s;
+        return sum / recent_similarities.size();
+    }
+    
+    void clear() {
+        recent_similarities.clear();
+    }
+};
+
+#endif
@@ -0,0 +1,242 @@
+// So sánh các bộ phát hiện khuôn mặt trên footage đã ghi có gán nhãn:
+// thời gian mỗi lần detect và recall (tỉ lệ khuôn mặt có nhãn được tìm thấy, IoU >= REPORT_IOU).
+//   make detector_report
+//   ./detector_report <clip.mp4 | thư mục ảnh> <labels.txt | -> [haar,dnn,haar_legacy]
+// labels.txt: mỗi dòng "frame x y w h" = 1 khuôn mặt, tọa độ trên frame đã resize về LCD_WIDTH x LCD_HEIGHT
+// (giống task_camera), frame đánh số từ 0; frame không có dòng nào = không có mặt. Dòng '#' bị bỏ qua.
+// "-" = không có nhãn (chỉ đo thời gian / so sánh giữa các detector).
+// haar_legacy = 1 lệnh detectMultiScale(gray, 1.05, 5, 0, 60..240) trên ảnh gốc như trước khi tối ưu;
+// chạy cùng haar thì in thêm độ khớp box (IoU, tỉ lệ khớp) và tỉ lệ thời gian giữa 2 đường.
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "camera_source.h"
+#include "face_detector.h"
+#include "frame_pool.h"
+
+#define REPORT_IOU    0.5   // Box detect trùng nhãn từ mức này trở lên thì tính là tìm thấy
+#define REPORT_WARMUP 3
+
+// Đường Haar gốc (1 luồng, ảnh đủ độ phân giải, grouping bên trong detectMultiScale) để đối chiếu
+class LegacyHaarDetector : public FaceDetector {
+public:
+    bool load() {
+        return cascade.load("/home/pi/opencv/data/haarcascades/haarcascade_frontalface_default.xml") ||
+               cascade.load("haarcascade_frontalface_default.xml");
+    }
+
+    void detect(const cv::Mat& frame, const cv::Mat& gray,
+                std::vector<cv::Rect>& faces, std::vector<float>& scores) {
+        cascade.detectMultiScale(gray, faces, 1.05, 5, 0, cv::Size(60, 60), cv::Size(240, 240));
+        scores.assign(faces.size(), 1.0f);
+    }
+
+    const char* name() const { return "haar_legacy"; }
+    bool needsColor() const { return false; }
+
+private:
+    cv::CascadeClassifier cascade;
+};
+
+struct DetectorRun {
+    std::string kind;
+    FaceDetector* det;
+    std::vector<double> ms;
+    std::vector<std::vector<cv::Rect> > boxes;  // Kết quả từng frame
+    int labelled;           // Tổng số khuôn mặt có nhãn
+    int found;              // Số khuôn mặt có nhãn được tìm thấy
+    int false_pos;          // Box không trùng nhãn nào
+};
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+static double iou(const cv::Rect& a, const cv::Rect& b) {
+    double inter = (a & b).area();
+    double uni = a.area() + b.area() - inter;
+    return uni > 0 ? inter / uni : 0.0;
+}
+
+static bool loadLabels(const char* path, std::map<int, std::vector<cv::Rect> >& labels) {
+    if (strcmp(path, "-") == 0) return true;
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    char line[256];
+    int n = 0;
+    while (fgets(line, sizeof(line), f)) {
+        int frame, x, y, w, h;
+        if (line[0] == '#' || sscanf(line, "%d %d %d %d %d", &frame, &x, &y, &w, &h) != 5) continue;
+        labels[frame].push_back(cv::Rect(x, y, w, h));
+        n++;
+    }
+    fclose(f);
+    printf("Labels: %d faces in %zu frames\n", n, labels.size());
+    return true;
+}
+
+// Ghép mỗi box của ref với box chưa dùng của faces có IoU lớn nhất (tham lam theo thứ tự ref).
+// Trả về số cặp khớp, iou_sum cộng IoU của các cặp, used đánh dấu box của faces đã ghép
+static int match(const std::vector<cv::Rect>& ref, const std::vector<cv::Rect>& faces,
+                 std::vector<bool>& used, double* iou_sum) {
+    used.assign(faces.size(), false);
+    int matched = 0;
+    for (size_t i = 0; i < ref.size(); i++) {
+        int best = -1;
+        double best_iou = REPORT_IOU;
+        for (size_t j = 0; j < faces.size(); j++) {
+            double v = iou(ref[i], faces[j]);
+            if (!used[j] && v >= best_iou) {
+                best = (int)j;
+                best_iou = v;
+            }
+        }
+        if (best >= 0) {
+            used[best] = true;
+            matched++;
+            if (iou_sum) *iou_sum += best_iou;
+        }
+    }
+    return matched;
+}
+
+static void score(DetectorRun& run, const std::vector<cv::Rect>& truth, const std::vector<cv::Rect>& faces) {
+    std::vector<bool> used;
+    run.found += match(truth, faces, used, NULL);
+    run.labelled += (int)truth.size();
+    for (size_t j = 0; j < faces.size(); j++) run.false_pos += !used[j];
+}
+
+static const DetectorRun* findRun(const std::vector<DetectorRun>& runs, const char* kind) {
+    for (size_t r = 0; r < runs.size(); r++) {
+        if (runs[r].kind == kind) return &runs[r];
+    }
+    return NULL;
+}
+
+// Đường Haar mới (thu nhỏ + chia dải scale + groupRectangles riêng) so với lệnh gốc trên cùng frame
+static void compareHaar(const DetectorRun& cur, const DetectorRun& legacy) {
+    int ref_boxes = 0, cur_boxes = 0, matched = 0, same_frames = 0;
+    double iou_sum = 0.0, ms_cur = 0.0, ms_legacy = 0.0;
+    std::vector<bool> used;
+    for (size_t i = 0; i < legacy.boxes.size(); i++) {
+        int m = match(legacy.boxes[i], cur.boxes[i], used, &iou_sum);
+        ref_boxes += (int)legacy.boxes[i].size();
+        cur_boxes += (int)cur.boxes[i].size();
+        matched += m;
+        same_frames += (m == (int)legacy.boxes[i].size() && m == (int)cur.boxes[i].size());
+        ms_cur += cur.ms[i];
+        ms_legacy += legacy.ms[i];
+    }
+    printf("\nhaar vs haar_legacy: matched %d/%d legacy boxes (%.1f%%), %d extra | mean IoU %.3f | "
+           "same boxes in %.1f%% of frames | wall clock %.2fx faster\n",
+           matched, ref_boxes, ref_boxes ? 100.0 * matched / ref_boxes : 100.0, cur_boxes - matched,
+           matched ? iou_sum / matched : 0.0, 100.0 * same_frames / legacy.boxes.size(),
+           ms_cur > 0.0 ? ms_legacy / ms_cur : 0.0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: %s <clip|frames_dir> <labels.txt|-> [haar,dnn,haar_legacy]\n", argv[0]);
+        return 1;
+    }
+    std::map<int, std::vector<cv::Rect> > labels;
+    if (!loadLabels(argv[2], labels)) return 1;
+
+    // Đọc hết footage 1 lần (resize + gray như task_camera / stage Detect), mọi detector chạy trên cùng frame
+    CameraSource src;
+    if (!camera_source_open(&src, argv[1], 0, 0)) return 1;
+    std::vector<cv::Mat> frames, grays;
+    cv::Mat raw;
+    while (camera_source_read(&src, raw) == 1) {
+        cv::Mat frame, gray;
+        cv::resize(raw, frame, cv::Size(LCD_WIDTH, LCD_HEIGHT));
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        frames.push_back(frame);
+        grays.push_back(gray);
+    }
+    camera_source_close(&src);
+    if (frames.empty()) {
+        printf("No frames in %s\n", argv[1]);
+        return 1;
+    }
+    printf("Footage: %zu frames %dx%d\n\n", frames.size(), LCD_WIDTH, LCD_HEIGHT);
+
+    std::vector<DetectorRun> runs;
+    std::string list = argc > 3 ? argv[3] : "haar,dnn";
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        DetectorRun run;
+        run.kind = list.substr(pos, comma - pos);
+        run.labelled = run.found = run.false_pos = 0;
+        pos = comma + 1;
+
+        // face_detector_create lùi về haar khi không nạp được -> kiểm tra tên để không đo nhầm
+        if (run.kind == "haar_legacy") {
+            run.det = new LegacyHaarDetector();
+            if (!run.det->load()) {
+                delete run.det;
+                run.det = NULL;
+            }
+        } else {
+            run.det = face_detector_create(run.kind.c_str());
+        }
+        if (!run.det || run.kind != run.det->name()) {
+            printf("Detector '%s' unavailable (skipped)\n", run.kind.c_str());
+            delete run.det;
+            continue;
+        }
+        runs.push_back(run);
+    }
+
+    std::vector<cv::Rect> faces;
+    std::vector<float> scores;
+    for (size_t r = 0; r < runs.size(); r++) {
+        DetectorRun& run = runs[r];
+        for (int i = 0; i < REPORT_WARMUP; i++) run.det->detect(frames[0], grays[0], faces, scores);
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            uint64_t t0 = frame_clock_ns();
+            run.det->detect(frames[i], grays[i], faces, scores);
+            run.ms.push_back((frame_clock_ns() - t0) / 1e6);
+            run.boxes.push_back(faces);
+
+            std::map<int, std::vector<cv::Rect> >::const_iterator it = labels.find((int)i);
+            score(run, it != labels.end() ? it->second : std::vector<cv::Rect>(), faces);
+        }
+    }
+
+    printf("\n");
+    for (size_t r = 0; r < runs.size(); r++) {
+        const DetectorRun& run = runs[r];
+        double sum = 0.0;
+        for (double v : run.ms) sum += v;
+        printf("%-11s detect avg %6.2f ms | p50 %6.2f | p95 %6.2f", run.kind.c_str(), sum / run.ms.size(),
+               percentile(run.ms, 0.50), percentile(run.ms, 0.95));
+        if (!labels.empty()) {
+            printf(" | recall %5.1f%% (%d/%d) | false pos/frame %.3f",
+                   run.labelled ? 100.0 * run.found / run.labelled : 0.0, run.found, run.labelled,
+                   (double)run.false_pos / frames.size());
+        }
+        printf("\n");
+    }
+
+    const DetectorRun* haar = findRun(runs, "haar");
+    const DetectorRun* legacy = findRun(runs, "haar_legacy");
+    if (haar && legacy) compareHaar(*haar, *legacy);
+
+    for (size_t r = 0; r < runs.size(); r++) delete runs[r].det;
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "embedding_store.h"
+
+static_assert(sizeof(EmbStoreHeader) == EMB_STORE_HEADER, "Header phai dung 64 byte");
+
+uint64_t embedding_store_hash_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+
+    uint64_t h = 1469598103934665603ULL;    // FNV-1a 64
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            h ^= buf[i];
+            h *= 1099511628211ULL;
+        }
+    }
+    fclose(f);
+    return h;
+}
+
+static int pwrite_all(int fd, const void* buf, size_t len, off_t off) {
+    const uint8_t* p = (const uint8_t*)buf;
+    while (len > 0) {
+        ssize_t w = pwrite(fd, p, len, off);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        p += w;
+        off += w;
+        len -= w;
+    }
+    return 1;
+}
+
+// Map kích thước mới trước, chỉ bỏ vùng cũ khi thành công -> thất bại thì vùng cũ (và gallery
+// đang trỏ vào nó) vẫn dùng được
+static int remap(EmbeddingStore* s) {
+    size_t size = EMB_STORE_HEADER + (size_t)s->header.count * s->header.record_bytes;
+    void* m = mmap(NULL, size, PROT_READ, MAP_SHARED, s->fd, 0);
+    if (m == MAP_FAILED) {
+        printf("[Store] mmap failed: %s\n", strerror(errno));
+        return 0;
+    }
+
+    if (s->map) munmap(s->map, s->map_size);
+    s->map = (uint8_t*)m;
+    s->map_size = size;
+    return 1;
+}
+
+int embedding_store_open(EmbeddingStore* s, const char* path, uint64_t model_hash) {
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    snprintf(s->path, sizeof(s->path), "%s", path);
+    s->header.magic = EMB_STORE_MAGIC;
+    s->header.version = EMB_STORE_VERSION;
+    s->header.model_hash = model_hash;
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        if (errno == ENOENT) return 0;     // Chưa đăng ký ai -> tạo khi append
+        printf("[Store] Cannot open %s: %s\n", path, strerror(errno));
+        s->path[0] = '\0';
+        return -1;
+    }
+
+    EmbStoreHeader h;
+    struct stat st;
+    const char* err = NULL;
+    if (pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) err = "short header";
+    else if (h.magic != EMB_STORE_MAGIC) err = "bad magic";
+    else if (h.version != EMB_STORE_VERSION) err = "unsupported version";
+    else if (h.dim == 0 || h.record_bytes != FaceGallery::recordBytes(h.dim)) err = "bad record size";
+    else if (h.model_hash != model_hash) err = "embeddings belong to a different model";
+    else if (fstat(fd, &st) != 0 ||
+             (size_t)st.st_size < EMB_STORE_HEADER + (size_t)h.count * h.record_bytes) err = "truncated file";
+
+    if (err) {
+        // Không ghi đè file lạ: tắt store, chỉ giữ gallery trong RAM
+        printf("[Store] Ignoring %s: %s\n", path, err);
+        close(fd);
+        s->path[0] = '\0';
+        return -1;
+    }
+
+    s->fd = fd;
+    s->header = h;
+    if (h.count > 0 && !remap(s)) {
+        embedding_store_close(s);
+        s->path[0] = '\0';
+        return -1;
+    }
+    return (int)h.count;
+}
+
+void embedding_store_close(EmbeddingStore* s) {
+    if (s->map) munmap(s->map, s->map_size);
+    if (s->fd >= 0) close(s->fd);
+    s->map = NULL;
+    s->map_size = 0;
+    s->fd = -1;
+}
+
+// Tạo file mới qua file tạm + rename để không bao giờ thấy header dở dang
+static int create_file(EmbeddingStore* s, int dim) {
+    char tmp[300];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", s->path);
+
+    s->header.dim = dim;
+    s->header.count = 0;
+    s->header.record_bytes = (uint32_t)FaceGallery::recordBytes(dim);
+
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return 0;
+    if (!pwrite_all(fd, &s->header, sizeof(s->header), 0) || fsync(fd) != 0 ||
+        rename(tmp, s->path) != 0) {
+        close(fd);
+        unlink(tmp);
+        return 0;
+    }
+
+    // fsync thư mục để tên file mới bền vững
+    char dir_buf[256];
+    snprintf(dir_buf, sizeof(dir_buf), "%s", s->path);
+    int dfd = open(dirname(dir_buf), O_RDONLY | O_DIRECTORY);
+    if (dfd >= 0) {
+        fsync(dfd);
+        close(dfd);
+    }
+
+    s->fd = fd;
+    return 1;
+}
+
+int embedding_store_append(EmbeddingStore* s, const char* name, const float* emb, int dim) {
+    if (s->path[0] == '\0') return EMB_STORE_NOT_WRITTEN;
+    if (s->fd < 0 && !create_file(s, dim)) {
+        printf("[Store] Cannot create %s: %s\n", s->path, strerror(errno));
+        return EMB_STORE_NOT_WRITTEN;
+    }
+    if ((int)s->header.dim != dim) {
+        printf("[Store] Dim mismatch (store %u, embedding %d)\n", s->header.dim, dim);
+        return EMB_STORE_NOT_WRITTEN;
+    }
+
+    size_t rec_bytes = s->header.record_bytes;
+    uint8_t* rec = (uint8_t*)calloc(1, rec_bytes);
+    if (!rec) return EMB_STORE_NOT_WRITTEN;
+    memcpy(rec, emb, dim * sizeof(float));
+    strncpy((char*)rec + rec_bytes - GALLERY_NAME_LEN, name, GALLERY_NAME_LEN - 1);
+
+    // 1. Bản ghi nằm sau count -> chưa commit, mất điện lúc này thì bị bỏ qua
+    off_t off = EMB_STORE_HEADER + (off_t)s->header.count * rec_bytes;
+    int ok = pwrite_all(s->fd, rec, rec_bytes, off) && fdatasync(s->fd) == 0;
+    free(rec);
+    if (!ok) return EMB_STORE_NOT_WRITTEN;
+
+    // 2. Commit: tăng count trong header (nằm gọn trong 1 sector)
+    s->header.count++;
+    if (!pwrite_all(s->fd, &s->header, sizeof(s->header), 0) || fdatasync(s->fd) != 0) {
+        s->header.count--;
+        return EMB_STORE_NOT_WRITTEN;
+    }
+
+    if (!remap(s)) {
+        printf("[Store] Record %u committed to %s but not mapped\n", s->header.count, s->path);
+        return EMB_STORE_NOT_REMAPPED;
+    }
+    return EMB_STORE_APPENDED;
+}
+
+void embedding_store_attach(EmbeddingStore* s, FaceGallery* g) {
+    // Số bản ghi theo vùng đã map (có thể ít hơn header.count nếu lần remap gần nhất thất bại)
+    int mapped = s->map ? (int)((s->map_size - EMB_STORE_HEADER) / s->header.record_bytes) : 0;
+    if (mapped == 0) return;
+    g->attach((int)s->header.dim, s->map + EMB_STORE_HEADER, mapped);
+}
@@ -0,0 +1,56 @@
+#ifndef EMBEDDING_STORE_H
+#define EMBEDDING_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "face_gallery.h"
+
+// File embedding đã đăng ký (phiên bản 1, little-endian):
+//   [Header 64 byte][Bản ghi 0][Bản ghi 1]...
+//   Bản ghi = đúng bố cục FaceGallery: float emb[dim] (đệm tới bội số 8) + char name[32]
+// Header.count là điểm commit: bản ghi ghi dở sau count (mất điện giữa chừng) bị bỏ qua.
+#define EMB_STORE_MAGIC   0x424D4546u   // "FEMB"
+#define EMB_STORE_VERSION 1
+#define EMB_STORE_HEADER  64
+
+struct EmbStoreHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dim;
+    uint32_t count;
+    uint32_t record_bytes;
+    uint32_t reserved0;
+    uint64_t model_hash;    // FNV-1a 64 của file model -> đổi model thì embedding cũ vô hiệu
+    uint8_t reserved[32];
+};
+
+typedef struct {
+    char path[256];
+    int fd;                 // -1 = file chưa tồn tại (tạo khi append lần đầu)
+    uint8_t* map;           // mmap toàn bộ file (chỉ đọc)
+    size_t map_size;
+    EmbStoreHeader header;
+} EmbeddingStore;
+
+// Hash nội dung file model (0 nếu không đọc được)
+uint64_t embedding_store_hash_file(const char* path);
+
+// Mở store: trả về số bản ghi (0 nếu file chưa có), -1 nếu file hỏng / khác model
+int  embedding_store_open(EmbeddingStore* s, const char* path, uint64_t model_hash);
+void embedding_store_close(EmbeddingStore* s);
+
+// Kết quả append
+enum EmbStoreAppendResult {
+    EMB_STORE_NOT_WRITTEN = 0,  // Không ghi được (file không đổi) -> chỉ giữ trong RAM
+    EMB_STORE_APPENDED,         // Đã commit và vùng mmap đã gồm bản ghi mới
+    EMB_STORE_NOT_REMAPPED,     // Đã commit xuống file nhưng mmap lại thất bại: vùng mmap cũ vẫn còn
+                                // hợp lệ (chưa gồm bản ghi mới), lần mở sau sẽ nạp bản ghi từ file
+};
+
+// Ghi thêm 1 danh tính (emb đã L2 normalize). Thứ tự: ghi bản ghi -> fsync -> ghi count -> fsync
+int  embedding_store_append(EmbeddingStore* s, const char* name, const float* emb, int dim);
+
+// Cho gallery trỏ thẳng vào vùng mmap (không parse, không copy) - chỉ các bản ghi đã map
+void embedding_store_attach(EmbeddingStore* s, FaceGallery* g);
+
+#endif
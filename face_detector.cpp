@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "face_detector.h"
+#include "config.h"
+
+// --- Haar cascade: ảnh thu nhỏ + chia dải scale cho nhiều luồng ---
+// detectMultiScale với minNeighbors=0 trả về toàn bộ ứng viên thô của từng scale, các scale độc lập nhau.
+// Mỗi worker quét 1 dải kích thước cửa sổ liên tiếp (đúng các scale mà lệnh gốc sẽ quét),
+// gộp lại rồi groupRectangles(5, 0.2) như detectMultiScale(minNeighbors=5) làm bên trong.
+// Với DETECTOR_HAAR_SCALE = 1 kết quả trùng lệnh gốc; < 1 thì lệch vài pixel do thu nhỏ.
+#define HAAR_SCALE_FACTOR  1.05
+#define HAAR_MIN_NEIGHBORS 5
+#define HAAR_GROUP_EPS     0.2
+#define HAAR_MIN_FACE      60
+#define HAAR_MAX_FACE      240
+
+class HaarFaceDetector;
+
+struct HaarWorker {
+    HaarFaceDetector* owner;
+    int index;
+    pthread_t thread;
+    cv::CascadeClassifier cascade;  // Mỗi luồng 1 bản (CascadeClassifier không an toàn khi gọi song song)
+    cv::Size min_size;              // Dải kích thước cửa sổ của worker này
+    cv::Size max_size;
+    std::vector<cv::Rect> found;
+};
+
+class HaarFaceDetector : public FaceDetector {
+public:
+    HaarFaceDetector() : n_threads(0), n_active(0), generation(0), pending(0), running(0) {
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&start_cond, NULL);
+        pthread_cond_init(&done_cond, NULL);
+    }
+
+    ~HaarFaceDetector() {
+        pthread_mutex_lock(&mutex);
+        running = 0;
+        pthread_cond_broadcast(&start_cond);
+        pthread_mutex_unlock(&mutex);
+        for (int i = 1; i < n_threads; i++) pthread_join(workers[i].thread, NULL);
+
+        pthread_cond_destroy(&done_cond);
+        pthread_cond_destroy(&start_cond);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    bool load() {
+        const char* path = "/home/pi/opencv/data/haarcascades/haarcascade_frontalface_default.xml";
+        if (!workers[0].cascade.load(path)) {
+            path = "haarcascade_frontalface_default.xml";
+            if (!workers[0].cascade.load(path)) return false;
+        }
+
+        running = 1;
+        n_threads = 1;
+        workers[0].owner = this;
+        workers[0].index = 0;
+        for (int i = 1; i < DETECTOR_HAAR_THREADS; i++) {
+            HaarWorker* w = &workers[i];
+            w->owner = this;
+            w->index = i;
+            if (!w->cascade.load(path) ||
+                pthread_create(&w->thread, NULL, worker_main, w) != 0) break;
+            n_threads++;
+        }
+        printf("[Detector] Haar: scale %.2f, %d thread(s)\n", (double)DETECTOR_HAAR_SCALE, n_threads);
+        return true;
+    }
+
+    void detect(const cv::Mat& frame, const cv::Mat& gray,
+                std::vector<cv::Rect>& faces, std::vector<float>& scores) {
+        const double s = DETECTOR_HAAR_SCALE;
+        input = gray;
+        if (s < 1.0) {
+            cv::resize(gray, small, cv::Size(), s, s, cv::INTER_AREA);
+            input = small;
+        }
+        if (input.size() != split_size) splitScales(input.size(), s);
+
+        // Worker 0 chạy trên luồng gọi, các worker còn lại chạy song song
+        pthread_mutex_lock(&mutex);
+        pending = n_active - 1;
+        generation++;
+        pthread_cond_broadcast(&start_cond);
+        pthread_mutex_unlock(&mutex);
+
+        runRange(0);
+
+        pthread_mutex_lock(&mutex);
+        while (pending > 0) pthread_cond_wait(&done_cond, &mutex);
+        pthread_mutex_unlock(&mutex);
+
+        faces.clear();
+        for (int i = 0; i < n_active; i++) {
+            faces.insert(faces.end(), workers[i].found.begin(), workers[i].found.end());
+        }
+        cv::groupRectangles(faces, HAAR_MIN_NEIGHBORS, HAAR_GROUP_EPS);
+
+        // Đưa box về tọa độ frame gốc
+        if (s < 1.0) {
+            for (size_t i = 0; i < faces.size(); i++) {
+                cv::Rect& r = faces[i];
+                r = cv::Rect(cvRound(r.x / s), cvRound(r.y / s),
+                             cvRound(r.width / s), cvRound(r.height / s));
+            }
+        }
+        scores.assign(faces.size(), 1.0f);
+    }
+
+    const char* name() const { return "haar"; }
+    bool needsColor() const { return false; }
+
+private:
+    static void* worker_main(void* arg) {
+        HaarWorker* w = (HaarWorker*)arg;
+        HaarFaceDetector* d = w->owner;
+        int seen = 0;
+
+        pthread_mutex_lock(&d->mutex);
+        while (1) {
+            while (d->running && d->generation == seen) pthread_cond_wait(&d->start_cond, &d->mutex);
+            if (!d->running) break;
+            seen = d->generation;
+            if (w->index >= d->n_active) continue;
+
+            pthread_mutex_unlock(&d->mutex);
+            d->runRange(w->index);
+            pthread_mutex_lock(&d->mutex);
+            if (--d->pending == 0) pthread_cond_signal(&d->done_cond);
+        }
+        pthread_mutex_unlock(&d->mutex);
+        return NULL;
+    }
+
+    void runRange(int i) {
+        HaarWorker* w = &workers[i];
+        w->cascade.detectMultiScale(input, w->found, HAAR_SCALE_FACTOR, 0, 0,
+                                    w->min_size, w->max_size);
+    }
+
+    // Liệt kê các scale giống vòng lặp trong detectMultiScale, chia thành các dải liên tiếp
+    // có khối lượng gần bằng nhau (chi phí ~ số vị trí cửa sổ: scale <= 2 bước 2 pixel, > 2 bước 1)
+    void splitScales(cv::Size img, double s) {
+        cv::Size win = workers[0].cascade.getOriginalWindowSize();
+        int min_face = cvRound(HAAR_MIN_FACE * s);
+        int max_face = cvRound(HAAR_MAX_FACE * s);
+
+        std::vector<cv::Size> sizes;
+        std::vector<double> cost;
+        double total = 0.0;
+        for (double f = 1.0; ; f *= HAAR_SCALE_FACTOR) {
+            cv::Size ws(cvRound(win.width * f), cvRound(win.height * f));
+            if (ws.width > max_face || ws.height > max_face ||
+                ws.width > img.width || ws.height > img.height) break;
+            if (ws.width < min_face || ws.height < min_face) continue;
+            double c = (img.width / f) * (img.height / f) / (f > 2.0 ? 1.0 : 4.0);
+            sizes.push_back(ws);
+            cost.push_back(c);
+            total += c;
+        }
+
+        split_size = img;
+        n_active = 0;
+        if (sizes.empty()) {
+            // Ảnh quá nhỏ: 1 worker với dải rỗng (không tìm thấy gì)
+            workers[0].min_size = cv::Size(max_face + 1, max_face + 1);
+            workers[0].max_size = cv::Size(max_face, max_face);
+            n_active = 1;
+            return;
+        }
+
+        double target = total / n_threads;
+        double acc = 0.0;
+        size_t first = 0;
+        for (size_t k = 0; k < sizes.size(); k++) {
+            acc += cost[k];
+            bool last = (k + 1 == sizes.size());
+            // Chỉ cắt khi cửa sổ kế tiếp lớn hơn hẳn (2 dải không chung scale nào)
+            bool can_cut = !last && sizes[k + 1].width > sizes[k].width &&
+                           sizes[k + 1].height > sizes[k].height;
+            if (last || (can_cut && acc >= target * (n_active + 1) && n_active + 1 < n_threads)) {
+                workers[n_active].min_size = sizes[first];
+                workers[n_active].max_size = sizes[k];
+                n_active++;
+                first = k + 1;
+            }
+        }
+    }
+
+    HaarWorker workers[DETECTOR_HAAR_THREADS];
+    int n_threads;          // Số worker đã khởi tạo (kể cả luồng gọi)
+    int n_active;           // Số dải scale của kích thước ảnh hiện tại
+    int generation;         // Tăng mỗi lần detect để đánh thức worker
+    int pending;            // Worker chưa xong
+    int running;
+    pthread_mutex_t mutex;
+    pthread_cond_t start_cond;
+    pthread_cond_t done_cond;
+
+    cv::Mat input;          // Ảnh xám đang quét (gốc hoặc đã thu nhỏ)
+    cv::Mat small;
+    cv::Size split_size;    // Kích thước ảnh đã chia dải scale
+};
+
+// --- DNN ONNX (YuNet qua cv::FaceDetectorYN, có từ OpenCV 4.5.4) ---
+// Chạy trên ảnh thu nhỏ DETECTOR_DNN_W x DETECTOR_DNN_H rồi nhân box về kích thước gốc.
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 || \
+    (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 4)))
+#define HAVE_FACE_DETECTOR_YN 1
+#endif
+
+class DnnFaceDetector : public FaceDetector {
+public:
+    bool load() {
+#ifdef HAVE_FACE_DETECTOR_YN
+        try {
+            net = cv::FaceDetectorYN::create(DETECTOR_DNN_MODEL, "",
+                                             cv::Size(DETECTOR_DNN_W, DETECTOR_DNN_H),
+                                             DETECTOR_DNN_SCORE, DETECTOR_DNN_NMS, 50);
+        } catch (const cv::Exception& e) {
+            printf("[Detector] Cannot load %s: %s\n", DETECTOR_DNN_MODEL, e.what());
+            return false;
+        }
+        return !net.empty();
+#else
+        printf("[Detector] OpenCV %s has no FaceDetectorYN (need >= 4.5.4)\n", CV_VERSION);
+        return false;
+#endif
+    }
+
+    void detect(const cv::Mat& frame, const cv::Mat& gray,
+                std::vector<cv::Rect>& faces, std::vector<float>& scores) {
+        faces.clear();
+        scores.clear();
+#ifdef HAVE_FACE_DETECTOR_YN
+        cv::resize(frame, small, cv::Size(DETECTOR_DNN_W, DETECTOR_DNN_H), 0, 0, cv::INTER_LINEAR);
+        net->detect(small, dets);
+
+        // Mỗi hàng: x, y, w, h, 5 landmark (10 số), score
+        float sx = (float)frame.cols / DETECTOR_DNN_W;
+        float sy = (float)frame.rows / DETECTOR_DNN_H;
+        cv::Rect bounds(0, 0, frame.cols, frame.rows);
+        for (int i = 0; i < dets.rows; i++) {
+            const float* d = dets.ptr<float>(i);
+            cv::Rect box(cvRound(d[0] * sx), cvRound(d[1] * sy),
+                         cvRound(d[2] * sx), cvRound(d[3] * sy));
+            box &= bounds;
+            if (box.area() <= 0) continue;
+            faces.push_back(box);
+            scores.push_back(d[14]);
+        }
+#endif
+    }
+
+    const char* name() const { return "dnn"; }
+
+private:
+#ifdef HAVE_FACE_DETECTOR_YN
+    cv::Ptr<cv::FaceDetectorYN> net;
+#endif
+    cv::Mat small;
+    cv::Mat dets;
+};
+
+FaceDetector* face_detector_create(const char* kind) {
+    FaceDetector* det = NULL;
+    if (strcmp(kind, "haar") == 0) det = new HaarFaceDetector();
+    else if (strcmp(kind, "dnn") == 0) det = new DnnFaceDetector();
+    else return NULL;
+
+    if (det->load()) return det;
+    delete det;
+
+    if (strcmp(kind, "haar") == 0) {
+        printf("[Detector] Error: Cannot load cascade!\n");
+        return NULL;
+    }
+    printf("[Detector] '%s' unavailable, falling back to haar\n", kind);
+    return face_detector_create("haar");
+}
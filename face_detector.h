@@ -0,0 +1,26 @@
+#ifndef FACE_DETECTOR_H
+#define FACE_DETECTOR_H
+
+#include <vector>
+#include <opencv4/opencv2/opencv.hpp>
+
+// Giao diện bộ phát hiện khuôn mặt: task AI không phụ thuộc backend cụ thể.
+// Box trả về theo tọa độ frame gốc, score trong [0, 1] (Haar luôn = 1).
+class FaceDetector {
+public:
+    virtual ~FaceDetector() {}
+
+    virtual bool load() = 0;
+    // frame: BGR, gray: ảnh xám của cùng frame (backend nào cần cái nào thì dùng cái đó)
+    virtual void detect(const cv::Mat& frame, const cv::Mat& gray,
+                        std::vector<cv::Rect>& faces, std::vector<float>& scores) = 0;
+    virtual const char* name() const = 0;
+    // false = chỉ dùng gray (frame YUYV khỏi phải dựng BGR)
+    virtual bool needsColor() const { return true; }
+};
+
+// Tạo detector theo tên ("haar" | "dnn"), NULL nếu tên lạ.
+// Backend dnn không load được thì tự lùi về haar.
+FaceDetector* face_detector_create(const char* kind);
+
+#endif
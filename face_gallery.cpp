@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "face_gallery.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GALLERY_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define GALLERY_NEON 1
+#endif
+
+#define GALLERY_MAX_DIM 1024
+
+// --- KERNEL DOT PRODUCT ---
+static float dot_f32_scalar(const float* a, const float* b, int n) {
+    float s = 0.0f;
+    for (int i = 0; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+static int32_t dot_i8_scalar(const int8_t* a, const int8_t* b, int n) {
+    int32_t s = 0;
+    for (int i = 0; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+#ifdef GALLERY_X86
+__attribute__((target("sse2")))
+static float dot_f32_sse2(const float* a, const float* b, int n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float t[4];
+    _mm_storeu_ps(t, _mm_add_ps(acc0, acc1));
+    float s = t[0] + t[1] + t[2] + t[3];
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_f32_avx2(const float* a, const float* b, int n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),     _mm256_loadu_ps(b + i),     acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 s4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    s4 = _mm_add_ps(s4, _mm_movehl_ps(s4, s4));
+    s4 = _mm_add_ss(s4, _mm_shuffle_ps(s4, s4, 1));
+    float s = _mm_cvtss_f32(s4);
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+__attribute__((target("avx2")))
+static int32_t dot_i8_avx2(const int8_t* a, const int8_t* b, int n) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // int8 -> int16, nhân + cộng từng cặp -> int32 (không tràn: |a*b| <= 127*127)
+        __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(a + i)));
+        __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    __m128i s4 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s4 = _mm_add_epi32(s4, _mm_shuffle_epi32(s4, _MM_SHUFFLE(1, 0, 3, 2)));
+    s4 = _mm_add_epi32(s4, _mm_shuffle_epi32(s4, _MM_SHUFFLE(2, 3, 0, 1)));
+    int32_t s = _mm_cvtsi128_si32(s4);
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+#endif
+
+#ifdef GALLERY_NEON
+static float dot_f32_neon(const float* a, const float* b, int n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+#if defined(__aarch64__)
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+#else
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+#endif
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+#if defined(__aarch64__)
+    float s = vaddvq_f32(acc);
+#else
+    float32x2_t s2 = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    float s = vget_lane_f32(vpadd_f32(s2, s2), 0);
+#endif
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+static int32_t dot_i8_neon(const int8_t* a, const int8_t* b, int n) {
+    int32x4_t acc = vdupq_n_s32(0);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        int8x16_t va = vld1q_s8(a + i);
+        int8x16_t vb = vld1q_s8(b + i);
+        acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va),  vget_low_s8(vb)));
+        acc = vpadalq_s16(acc, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+    }
+#if defined(__aarch64__)
+    int32_t s = vaddvq_s32(acc);
+#else
+    int32x2_t s2 = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    int32_t s = vget_lane_s32(vpadd_s32(s2, s2), 0);
+#endif
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+#endif
+
+// --- CHỌN KERNEL LÚC CHẠY ---
+struct DotKernels {
+    float (*f32)(const float*, const float*, int);
+    int32_t (*i8)(const int8_t*, const int8_t*, int);
+    const char* name;
+};
+
+static DotKernels pick_kernels() {
+#ifdef GALLERY_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return { dot_f32_avx2, dot_i8_avx2, "avx2" };
+    }
+    if (__builtin_cpu_supports("sse2")) return { dot_f32_sse2, dot_i8_scalar, "sse2" };
+#endif
+#ifdef GALLERY_NEON
+    return { dot_f32_neon, dot_i8_neon, "neon" };
+#endif
+    return { dot_f32_scalar, dot_i8_scalar, "scalar" };
+}
+
+static const DotKernels& kernels() {
+    static const DotKernels k = pick_kernels();
+    return k;
+}
+
+// Giữ top-k theo score giảm dần (k nhỏ -> chèn trực tiếp)
+static void topk_insert(GalleryMatch* top, int& count, int k, int index, float score) {
+    if (count == k && score <= top[k - 1].score) return;
+    int pos = (count < k) ? count++ : k - 1;
+    while (pos > 0 && top[pos - 1].score < score) {
+        top[pos] = top[pos - 1];
+        pos--;
+    }
+    top[pos].index = index;
+    top[pos].score = score;
+}
+
+// Lượng tử hóa đối xứng: q = round(x / scale), scale = max|x| / 127
+static float quantize(const float* x, int n, int8_t* q) {
+    float m = 0.0f;
+    for (int i = 0; i < n; i++) m = fmaxf(m, fabsf(x[i]));
+    float scale = (m > 0.0f) ? m / 127.0f : 1.0f;
+    float inv = 1.0f / scale;
+    for (int i = 0; i < n; i++) {
+        int v = (int)lrintf(x[i] * inv);
+        q[i] = (int8_t)(v > 127 ? 127 : (v < -127 ? -127 : v));
+    }
+    return scale;
+}
+
+// --- FACE GALLERY ---
+FaceGallery::FaceGallery()
+    : d(0), n(0), cap(0), rec_bytes(0), records(NULL), owned(NULL),
+      use_int8(false), q_stride(0), q_data(NULL), q_scale(NULL), q_cap(0) {}
+
+FaceGallery::~FaceGallery() {
+    free(owned);
+    free(q_data);
+    free(q_scale);
+}
+
+size_t FaceGallery::recordBytes(int dim) {
+    return ((dim + 7) / 8) * 8 * sizeof(float) + GALLERY_NAME_LEN;
+}
+
+const char* FaceGallery::kernelName() {
+    return kernels().name;
+}
+
+void FaceGallery::init(int dim) {
+    if (dim <= 0 || dim > GALLERY_MAX_DIM) {
+        printf("[Gallery] Unsupported embedding dim %d\n", dim);
+        dim = 0;
+    }
+    free(owned);
+    owned = NULL;
+    records = NULL;
+    d = dim;
+    n = 0;
+    cap = 0;
+    rec_bytes = recordBytes(dim);
+    q_stride = ((dim + 31) / 32) * 32;
+    rebuildInt8();
+}
+
+void FaceGallery::attach(int dim, const uint8_t* recs, int count) {
+    init(dim);
+    if (d == 0) return;
+    records = recs;
+    n = count;
+    rebuildInt8();
+}
+
+void FaceGallery::reserve(int count) {
+    if (count <= cap && owned) return;
+    int new_cap = cap ? cap : 16;
+    while (new_cap < count) new_cap *= 2;
+
+    void* mem = NULL;
+    if (posix_memalign(&mem, 32, new_cap * rec_bytes) != 0) return;
+    memset(mem, 0, new_cap * rec_bytes);
+    // Đang attach hoặc đã có dữ liệu -> copy sang vùng nhớ riêng
+    if (records && n > 0) memcpy(mem, records, n * rec_bytes);
+    free(owned);
+    owned = (uint8_t*)mem;
+    records = owned;
+    cap = new_cap;
+}
+
+int FaceGallery::add(const char* name, const float* emb) {
+    if (d == 0) return -1;
+    reserve(n + 1);
+    if (n + 1 > cap) return -1;
+
+    uint8_t* rec = owned + n * rec_bytes;
+    float* row = (float*)rec;
+    float norm = sqrtf(dot_f32_scalar(emb, emb, d));
+    float inv = (norm > 1e-6f) ? 1.0f / norm : 1.0f;
+    for (int i = 0; i < d; i++) row[i] = emb[i] * inv;
+
+    char* dst = (char*)(rec + rec_bytes - GALLERY_NAME_LEN);
+    strncpy(dst, name ? name : "", GALLERY_NAME_LEN - 1);
+    dst[GALLERY_NAME_LEN - 1] = '\0';
+
+    n++;
+    if (use_int8) {
+        if (n > q_cap) rebuildInt8();
+        else quantizeRow(n - 1);
+    }
+    return n - 1;
+}
+
+const char* FaceGallery::name(int i) const {
+    return (const char*)(records + i * rec_bytes + rec_bytes - GALLERY_NAME_LEN);
+}
+
+const float* FaceGallery::embedding(int i) const {
+    return (const float*)(records + i * rec_bytes);
+}
+
+void FaceGallery::setInt8(bool on) {
+    use_int8 = on;
+    rebuildInt8();
+}
+
+void FaceGallery::quantizeRow(int i) {
+    int8_t* q = q_data + (size_t)i * q_stride;
+    memset(q, 0, q_stride);
+    q_scale[i] = quantize(embedding(i), d, q);
+}
+
+void FaceGallery::rebuildInt8() {
+    free(q_data);
+    free(q_scale);
+    q_data = NULL;
+    q_scale = NULL;
+    q_cap = 0;
+    if (!use_int8 || d == 0) return;
+
+    q_cap = (n > 16) ? n * 2 : 32;
+    void* mem = NULL;
+    if (posix_memalign(&mem, 32, (size_t)q_cap * q_stride) != 0) {
+        q_cap = 0;
+        return;
+    }
+    q_data = (int8_t*)mem;
+    q_scale = (float*)malloc(q_cap * sizeof(float));
+    if (!q_scale) {
+        // Thiếu bộ nhớ -> bỏ int8, search() tự lùi về quét float32
+        free(q_data);
+        q_data = NULL;
+        q_cap = 0;
+        return;
+    }
+    for (int i = 0; i < n; i++) quantizeRow(i);
+}
+
+int FaceGallery::search(const float* query, int k, GalleryMatch* out) const {
+    if (n == 0 || d == 0 || k <= 0) return 0;
+    if (k > n) k = n;
+
+    const DotKernels& kr = kernels();
+    int count = 0;
+
+    if (use_int8 && q_data && k <= GALLERY_RERANK) {
+        // 1. Quét toàn bộ bằng int8
+        int8_t q[GALLERY_MAX_DIM];
+        float qs = quantize(query, d, q);
+
+        GalleryMatch cand[GALLERY_RERANK];
+        int n_cand = 0;
+        int keep = (n < GALLERY_RERANK) ? n : GALLERY_RERANK;
+        for (int i = 0; i < n; i++) {
+            float s = kr.i8(q_data + (size_t)i * q_stride, q, d) * q_scale[i] * qs;
+            topk_insert(cand, n_cand, keep, i, s);
+        }
+
+        // 2. Tính lại chính xác các ứng viên bằng float32
+        for (int c = 0; c < n_cand; c++) {
+            int i = cand[c].index;
+            topk_insert(out, count, k, i, kr.f32(embedding(i), query, d));
+        }
+        return count;
+    }
+
+    for (int i = 0; i < n; i++) {
+        topk_insert(out, count, k, i, kr.f32(embedding(i), query, d));
+    }
+    return count;
+}
@@ -0,0 +1,69 @@
+#ifndef FACE_GALLERY_H
+#define FACE_GALLERY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GALLERY_NAME_LEN 32     // Tên danh tính tối đa (kể cả '\0')
+#define GALLERY_RERANK   16     // Chế độ int8: số ứng viên tính lại bằng float32
+
+struct GalleryMatch {
+    int index;
+    float score;                // Cosine similarity
+};
+
+// Kho nhiều danh tính: N embedding đã L2 normalize xếp liền nhau trong 1 vùng nhớ căn lề 32 byte.
+// Mỗi bản ghi = [float emb[dim] (đệm tới bội số 8)] [char name[GALLERY_NAME_LEN]],
+// cùng bố cục với file embedding nên có thể trỏ thẳng vào vùng mmap (attach) mà không copy.
+class FaceGallery {
+public:
+    FaceGallery();
+    ~FaceGallery();
+
+    // Xóa hết, dùng bộ nhớ riêng với số chiều dim
+    void init(int dim);
+    // Dùng bản ghi có sẵn (vd. vùng mmap) - không copy, vùng nhớ phải sống lâu hơn gallery
+    void attach(int dim, const uint8_t* records, int count);
+
+    // Thêm danh tính (embedding được normalize lại), trả về index
+    int add(const char* name, const float* emb);
+
+    int size() const { return n; }
+    int dim() const { return d; }
+    const char* name(int i) const;
+    const float* embedding(int i) const;
+
+    // Bật bản sao int8 (lượng tử hóa đối xứng theo từng hàng) để quét nhanh hơn,
+    // top GALLERY_RERANK ứng viên được tính lại chính xác bằng float32
+    void setInt8(bool on);
+    bool int8Enabled() const { return use_int8; }
+
+    // Top-k theo cosine similarity, trả về số kết quả (giảm dần theo score)
+    int search(const float* query, int k, GalleryMatch* out) const;
+
+    static size_t recordBytes(int dim);
+    static const char* kernelName();
+
+private:
+    FaceGallery(const FaceGallery&);
+    FaceGallery& operator=(const FaceGallery&);
+
+    void reserve(int count);
+    void quantizeRow(int i);
+    void rebuildInt8();
+
+    int d;
+    int n;
+    int cap;
+    size_t rec_bytes;
+    const uint8_t* records;     // Bản ghi đang dùng (owned hoặc attach)
+    uint8_t* owned;             // NULL nếu đang attach
+
+    bool use_int8;
+    int q_stride;               // Số byte mỗi hàng int8 (đệm tới bội số 32)
+    int8_t* q_data;
+    float* q_scale;
+    int q_cap;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include <utility>
+#include <algorithm>
+#include "face_job.h"
+
+cv::Mat FaceJob::crop() const {
+    if (frame.format() != FRAME_FORMAT_YUYV) return frame.mat()(best.box);
+
+    // Mỗi cặp pixel YUYV dùng chung U/V -> vùng đổi màu phải bắt đầu ở x chẵn, rộng chẵn
+    const cv::Mat& yuyv = frame.yuyv();
+    int x0 = best.box.x & ~1;
+    int x1 = std::min((best.box.x + best.box.width + 1) & ~1, yuyv.cols & ~1);
+    cv::Rect aligned(x0, best.box.y, x1 - x0, best.box.height);
+    cv::Mat bgr;
+    cv::cvtColor(yuyv(aligned), bgr, cv::COLOR_YUV2BGR_YUYV);
+    return bgr(cv::Rect(best.box.x - x0, 0, best.box.width, best.box.height));
+}
+
+void face_job_queue_init(FaceJobQueue* q) {
+    q->head = 0;
+    q->count = 0;
+    q->closed = 0;
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+}
+
+void face_job_queue_free(FaceJobQueue* q) {
+    for (int i = 0; i < AI_HANDOFF_SIZE; i++) {
+        q->jobs[i].frame.reset();
+    }
+    pthread_cond_destroy(&q->not_full);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_mutex_destroy(&q->mutex);
+}
+
+int face_job_queue_push(FaceJobQueue* q, FaceJob& job) {
+    pthread_mutex_lock(&q->mutex);
+    while (!q->closed && q->count == AI_HANDOFF_SIZE) {
+        pthread_cond_wait(&q->not_full, &q->mutex);
+    }
+    if (q->closed) {
+        pthread_mutex_unlock(&q->mutex);
+        return 0;
+    }
+    // Chuyển (move) để không tăng/giảm tham chiếu và không copy vector box
+    q->jobs[(q->head + q->count) % AI_HANDOFF_SIZE] = std::move(job);
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->mutex);
+    return 1;
+}
+
+int face_job_queue_pop(FaceJobQueue* q, FaceJob* job_out) {
+    pthread_mutex_lock(&q->mutex);
+    while (!q->closed && q->count == 0) {
+        pthread_cond_wait(&q->not_empty, &q->mutex);
+    }
+    if (q->count == 0) {
+        pthread_mutex_unlock(&q->mutex);
+        return 0;
+    }
+    *job_out = std::move(q->jobs[q->head]);
+    q->head = (q->head + 1) % AI_HANDOFF_SIZE;
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->mutex);
+    return 1;
+}
+
+void face_job_queue_close(FaceJobQueue* q) {
+    pthread_mutex_lock(&q->mutex);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->mutex);
+}
@@ -0,0 +1,49 @@
+#ifndef FACE_JOB_H
+#define FACE_JOB_H
+
+#include <vector>
+#include <pthread.h>
+#include <opencv4/opencv2/opencv.hpp>
+#include "config.h"
+#include "frame_pool.h"
+
+// Khuôn mặt ứng viên: quality tính 1 lần lúc chọn, dùng lại ở mọi bước sau
+struct FaceCandidate {
+    cv::Rect box;                   // area 0 = không có
+    float quality;
+};
+
+// Kết quả stage Detect gửi sang stage Recognize.
+// Giữ handle của frame (không copy ảnh): crop khuôn mặt là ROI trên frame pool.
+struct FaceJob {
+    FrameHandle frame;
+    std::vector<cv::Rect> faces;    // Tất cả box detect/track được
+    FaceCandidate best;             // Box đã chọn + quality (box.area() 0 = không có box đạt yêu cầu)
+    int64 t_start;                  // cv::getTickCount lúc bắt đầu detect (đo latency cả 2 stage)
+
+    // Frame BGR: ROI trên frame pool (không copy). Frame YUYV: chỉ đổi vùng khuôn mặt sang BGR
+    cv::Mat crop() const;
+};
+
+// Hàng đợi có giới hạn giữa 2 stage: đầy thì stage Detect chờ (Detect chỉ lấy frame
+// mới nhất từ ai_channel nên chờ ở đây không làm dồn frame cũ)
+typedef struct {
+    FaceJob jobs[AI_HANDOFF_SIZE];
+    int head;
+    int count;
+    int closed;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} FaceJobQueue;
+
+void face_job_queue_init(FaceJobQueue* q);
+void face_job_queue_free(FaceJobQueue* q);
+
+// Trả về 0 nếu queue đã đóng (job bị bỏ)
+int  face_job_queue_push(FaceJobQueue* q, FaceJob& job);
+// Trả về 0 nếu queue đã đóng và hết job
+int  face_job_queue_pop(FaceJobQueue* q, FaceJob* job_out);
+void face_job_queue_close(FaceJobQueue* q);
+
+#endif
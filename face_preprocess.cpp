@@ -0,0 +1,93 @@
+#include <math.h>
+#include "face_preprocess.h"
+
+#define COEF_BITS  11
+#define COEF_SCALE (1 << COEF_BITS)     // INTER_RESIZE_COEF_SCALE của OpenCV
+
+// (v - 127.5) / 128 cho 256 giá trị 8 bit
+struct NormLut {
+    float v[256];
+    NormLut() {
+        for (int i = 0; i < 256; i++) v[i] = (float)((i - 127.5) / 128.0);
+    }
+};
+
+static inline uint8_t clamp_u8(int v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// Tọa độ nguồn + hệ số nội suy của 1 trục, giống resizeGeneric (INTER_LINEAR) của OpenCV
+static void linear_coeffs(int src_size, int dst_size, int* ofs, short* coef, bool clamp) {
+    double scale = 1.0 / ((double)dst_size / src_size);
+    for (int d = 0; d < dst_size; d++) {
+        float f = (float)((d + 0.5) * scale - 0.5);
+        int s = (int)floorf(f);
+        f -= s;
+        if (clamp) {
+            if (s < 0) { f = 0; s = 0; }
+            if (s >= src_size - 1) { f = 0; s = src_size - 1; }
+        }
+        ofs[d] = s;
+        coef[d * 2]     = (short)lrintf((1.f - f) * COEF_SCALE);
+        coef[d * 2 + 1] = (short)lrintf(f * COEF_SCALE);
+    }
+}
+
+void face_preprocess_fused(const uint8_t* src, int width, int height, size_t stride, float* dst) {
+    static const NormLut lut;
+    const int N = FACE_INPUT_SIZE;
+    float* out_r = dst;
+    float* out_g = dst + N * N;
+    float* out_b = dst + 2 * N * N;
+
+    // Đúng 2x: cv::resize chuyển sang INTER_AREA, trung bình 2x2 làm tròn (sum + 2) >> 2
+    if (width == 2 * N && height == 2 * N) {
+        for (int dy = 0; dy < N; dy++) {
+            const uint8_t* r0 = src + (size_t)(2 * dy) * stride;
+            const uint8_t* r1 = r0 + stride;
+            for (int dx = 0; dx < N; dx++) {
+                const uint8_t* p0 = r0 + dx * 6;
+                const uint8_t* p1 = r1 + dx * 6;
+                int i = dy * N + dx;
+                out_b[i] = lut.v[(p0[0] + p0[3] + p1[0] + p1[3] + 2) >> 2];
+                out_g[i] = lut.v[(p0[1] + p0[4] + p1[1] + p1[4] + 2) >> 2];
+                out_r[i] = lut.v[(p0[2] + p0[5] + p1[2] + p1[5] + 2) >> 2];
+            }
+        }
+        return;
+    }
+
+    int xofs[FACE_INPUT_SIZE], yofs[FACE_INPUT_SIZE];
+    short alpha[FACE_INPUT_SIZE * 2], beta[FACE_INPUT_SIZE * 2];
+    linear_coeffs(width, N, xofs, alpha, true);
+    linear_coeffs(height, N, yofs, beta, false);    // Trục y: hàng ngoài biên được kẹp lại
+
+    for (int dy = 0; dy < N; dy++) {
+        int sy0 = yofs[dy], sy1 = sy0 + 1;
+        sy0 = sy0 < 0 ? 0 : (sy0 > height - 1 ? height - 1 : sy0);
+        sy1 = sy1 < 0 ? 0 : (sy1 > height - 1 ? height - 1 : sy1);
+        const uint8_t* r0 = src + (size_t)sy0 * stride;
+        const uint8_t* r1 = src + (size_t)sy1 * stride;
+        int b0 = beta[dy * 2], b1 = beta[dy * 2 + 1];
+
+        for (int dx = 0; dx < N; dx++) {
+            int sx0 = xofs[dx] * 3;
+            int sx1 = (xofs[dx] + 1 < width ? xofs[dx] + 1 : xofs[dx]) * 3;
+            int a0 = alpha[dx * 2], a1 = alpha[dx * 2 + 1];
+            uint8_t px[3];
+
+            for (int c = 0; c < 3; c++) {
+                // Ngang (hệ số 11 bit) rồi dọc, làm tròn như VResizeLinear<uchar> của OpenCV
+                int s0 = r0[sx0 + c] * a0 + r0[sx1 + c] * a1;
+                int s1 = r1[sx0 + c] * a0 + r1[sx1 + c] * a1;
+                px[c] = clamp_u8((((b0 * (s0 >> 4)) >> 16) + ((b1 * (s1 >> 4)) >> 16) + 2) >> 2);
+            }
+
+            // BGR -> mặt phẳng R, G, B
+            int i = dy * N + dx;
+            out_r[i] = lut.v[px[2]];
+            out_g[i] = lut.v[px[1]];
+            out_b[i] = lut.v[px[0]];
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef FACE_PREPROCESS_H
+#define FACE_PREPROCESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FACE_INPUT_SIZE 112     // Cạnh ảnh đầu vào MobileFaceNet
+
+// Tiền xử lý gộp 1 lượt: ROI BGR 8 bit (kích thước, stride bất kỳ) -> 3 mặt phẳng float R, G, B
+// 112x112 liền nhau (1 ảnh trong blob NCHW), giá trị (v - 127.5) / 128.
+// Phép resize tái tạo cv::resize INTER_LINEAR cho 8U (hệ số fixed-point 11 bit, cùng cách làm tròn;
+// đúng 2x thì dùng trung bình 2x2 như OpenCV) nên kết quả khớp preprocessFaceStandard
+// (HAL riêng của OpenCV trên ARM có thể lệch 1 mức 8 bit = 1/128).
+void face_preprocess_fused(const uint8_t* src, int width, int height, size_t stride, float* dst);
+
+#endif
@@ -0,0 +1,62 @@
+#include <math.h>
+#include "face_quality.h"
+
+// Chỉ số reflect101 trong [0, n): -1 -> 1, n -> n-2
+static inline int reflect101(int i, int n) {
+    if (i < 0) return n > 1 ? -i : 0;
+    if (i >= n) return n > 1 ? 2 * n - 2 - i : 0;
+    return i;
+}
+
+float face_quality_gray(const uint8_t* src, int width, int height, size_t stride) {
+    if (width < 40 || height < 40) return 0.0f;
+
+    int64_t sum = 0;        // Tổng độ sáng
+    int64_t lap_sum = 0;    // Tổng Laplacian
+    int64_t lap_sq = 0;     // Tổng bình phương Laplacian
+    int vmin = 255, vmax = 0;
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = src + (size_t)y * stride;
+        const uint8_t* up = src + (size_t)reflect101(y - 1, height) * stride;
+        const uint8_t* down = src + (size_t)reflect101(y + 1, height) * stride;
+        int32_t row_sum = 0;
+
+        for (int x = 0; x < width; x++) {
+            int c = row[x];
+            int left = row[x > 0 ? x - 1 : 1];
+            int right = row[x < width - 1 ? x + 1 : width - 2];
+            int lap = up[x] + down[x] + left + right - 4 * c;
+
+            row_sum += c;
+            lap_sum += lap;
+            lap_sq += lap * lap;
+            if (c < vmin) vmin = c;
+            if (c > vmax) vmax = c;
+        }
+        sum += row_sum;
+    }
+
+    double n = (double)width * height;
+    float score = 0.0f;
+
+    // 1. Kích thước
+    float size_score = fminf(1.0f, (width * height) / 8000.0f);
+    score += size_score * 0.25f;
+
+    // 2. Độ sắc nét (phương sai Laplacian)
+    double lap_mean = lap_sum / n;
+    double variance = lap_sq / n - lap_mean * lap_mean;
+    float sharpness = (float)(variance > 0.0 ? variance : 0.0);
+    score += fminf(1.0f, sharpness / 400.0f) * 0.35f;
+
+    // 3. Độ sáng (không quá tối hoặc quá sáng)
+    float brightness = (float)(sum / n);
+    score += (1.0f - fabsf(brightness - 127.0f) / 127.0f) * 0.25f;
+
+    // 4. Độ tương phản
+    float contrast = (vmax - vmin) / 255.0f;
+    score += fminf(1.0f, contrast) * 0.15f;
+
+    return score;
+}
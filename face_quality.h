@@ -0,0 +1,12 @@
+#ifndef FACE_QUALITY_H
+#define FACE_QUALITY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Điểm chất lượng khuôn mặt [0, 1] tính 1 lượt trên ROI của ảnh xám đã có sẵn (không cvtColor lại):
+// kích thước, phương sai Laplacian (kernel 3x3 ksize=1, biên reflect101 trong ROI), độ sáng TB, min/max.
+// Tích lũy bằng số nguyên 64 bit, cùng công thức/trọng số với FaceNet::assessFaceQuality (bản tham chiếu).
+float face_quality_gray(const uint8_t* src, int width, int height, size_t stride);
+
+#endif
@@ -0,0 +1,55 @@
+#include "face_tracker.h"
+#include "config.h"
+
+void FaceTracker::start(const cv::Mat& gray, const cv::Rect& box) {
+    cv::Rect b = box & cv::Rect(0, 0, gray.cols, gray.rows);
+    if (b.area() <= 0) {
+        is_active = false;
+        return;
+    }
+
+    scale = (double)TRACK_TEMPLATE_SIZE / std::max(b.width, b.height);
+    if (scale > 1.0) scale = 1.0;
+    cv::resize(gray(b), templ, cv::Size(), scale, scale, cv::INTER_AREA);
+
+    last_box = b;
+    frames = 0;
+    is_active = true;
+}
+
+bool FaceTracker::update(const cv::Mat& gray, cv::Rect& box, float& score) {
+    score = 0.0f;
+    if (!is_active) return false;
+
+    // Vùng tìm kiếm = box cũ nới rộng mỗi phía TRACK_SEARCH_MARGIN lần kích thước
+    int mx = (int)(last_box.width * TRACK_SEARCH_MARGIN);
+    int my = (int)(last_box.height * TRACK_SEARCH_MARGIN);
+    cv::Rect search(last_box.x - mx, last_box.y - my,
+                    last_box.width + 2 * mx, last_box.height + 2 * my);
+    search &= cv::Rect(0, 0, gray.cols, gray.rows);
+
+    cv::resize(gray(search), search_small, cv::Size(), scale, scale, cv::INTER_AREA);
+    if (search_small.cols < templ.cols || search_small.rows < templ.rows) {
+        is_active = false;
+        return false;
+    }
+
+    cv::matchTemplate(search_small, templ, result, cv::TM_CCOEFF_NORMED);
+    double max_val;
+    cv::Point max_loc;
+    cv::minMaxLoc(result, NULL, &max_val, NULL, &max_loc);
+    score = (float)max_val;
+
+    if (score < TRACK_MIN_SCORE) {
+        is_active = false;
+        return false;
+    }
+
+    // Đổi về tọa độ ảnh gốc, giữ nguyên kích thước box lúc detect
+    last_box.x = search.x + (int)(max_loc.x / scale + 0.5);
+    last_box.y = search.y + (int)(max_loc.y / scale + 0.5);
+    last_box &= cv::Rect(0, 0, gray.cols, gray.rows);
+    box = last_box;
+    frames++;
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef FACE_TRACKER_H
+#define FACE_TRACKER_H
+
+#include <opencv4/opencv2/opencv.hpp>
+
+// Bám khuôn mặt giữa các lần detect bằng template matching (NCC) trên ảnh xám.
+// Template và vùng tìm kiếm được thu nhỏ về ~TRACK_TEMPLATE_SIZE pixel nên mỗi frame chỉ tốn vài trăm µs.
+class FaceTracker {
+public:
+    FaceTracker() : is_active(false), frames(0), scale(1.0) {}
+
+    // Bắt đầu bám từ 1 box vừa detect
+    void start(const cv::Mat& gray, const cv::Rect& box);
+
+    // Tìm box ở frame mới. Trả về false nếu mất dấu (score < ngưỡng hoặc ra khỏi ảnh)
+    bool update(const cv::Mat& gray, cv::Rect& box, float& score);
+
+    void stop() { is_active = false; }
+    bool active() const { return is_active; }
+    int framesTracked() const { return frames; }
+
+private:
+    bool is_active;
+    int frames;             // Số frame đã bám kể từ lần detect gần nhất
+    double scale;           // Hệ số thu nhỏ template / ảnh
+    cv::Rect last_box;      // Theo tọa độ ảnh gốc
+    cv::Mat templ;          // Template đã thu nhỏ
+    cv::Mat search_small;
+    cv::Mat result;
+};
+
+#endif
@@ -7,16 +7,29 @@
 #include <string>
 #include <vector>
 #include <cmath>
+#include "face_preprocess.h"
+
+// Mẫu đăng ký: ảnh gốc + embedding + quality tính 1 lần lúc thu mẫu
+struct EnrollSample {
+    cv::Mat face;
+    cv::Mat embedding;      // 1 x D, đã L2 normalize
+    float quality;
+};
 
 class FaceNet {
 private:
     cv::dnn::Net net;
     bool is_loaded = false;
+    int max_batch = 8;          // Số ảnh tối đa mỗi lần forward (1 = không batch)
+    int emb_dim = 0;            // Số chiều embedding (đo lúc load)
+    cv::Mat input_blob;         // N x 3 x 112 x 112, dùng lại giữa các lần forward (không cấp phát mỗi ảnh)
 
+public:
     // ---------------------------
     // Chuẩn hóa preprocessing theo InsightFace/ArcFace
+    // Bản tham chiếu (nhiều Mat trung gian) - đường chính dùng face_preprocess_fused, phải cho cùng blob
     // ---------------------------
-    cv::Mat preprocessFaceStandard(const cv::Mat& face_img) {
+    static cv::Mat preprocessFaceStandard(const cv::Mat& face_img) {
         if (face_img.empty()) return cv::Mat();
 
         cv::Mat processed;
@@ -34,6 +47,82 @@ private:
         return processed;
     }
 
+private:
+    void resizeBlob(int n) {
+        int size[] = {n, 3, FACE_INPUT_SIZE, FACE_INPUT_SIZE};
+        input_blob.create(4, size, CV_32F);     // Cùng kích thước -> giữ nguyên bộ nhớ
+    }
+
+    // Ghi ảnh vào vị trí slot của input_blob: BGR 8 bit đi qua kernel gộp 1 lượt,
+    // loại ảnh khác đi đường tham chiếu
+    bool fillBlob(const cv::Mat& face_img, int slot) {
+        float* dst = input_blob.ptr<float>(slot);
+        if (face_img.type() == CV_8UC3) {
+            face_preprocess_fused(face_img.data, face_img.cols, face_img.rows, face_img.step, dst);
+            return true;
+        }
+
+        cv::Mat processed = preprocessFaceStandard(face_img);
+        if (processed.empty()) return false;
+        const int plane = FACE_INPUT_SIZE * FACE_INPUT_SIZE;
+        std::vector<cv::Mat> planes;
+        for (int c = 0; c < 3; c++) {
+            planes.push_back(cv::Mat(FACE_INPUT_SIZE, FACE_INPUT_SIZE, CV_32F, dst + c * plane));
+        }
+        cv::split(processed, planes);
+        return true;
+    }
+
+    // ---------------------------
+    // Forward 1 batch ảnh face_imgs[idx[k]], ghi embedding (đã L2 normalize) vào results[idx[k]]
+    // ---------------------------
+    void forwardBatch(const std::vector<cv::Mat>& face_imgs,
+                      const std::vector<size_t>& idx,
+                      std::vector<cv::Mat>& results) {
+        int n = (int)idx.size();
+        if (n == 0) return;
+
+        cv::Mat out;
+        if (n > 1) {
+            try {
+                resizeBlob(n);
+                for (int k = 0; k < n; k++) fillBlob(face_imgs[idx[k]], k);
+                net.setInput(input_blob);
+                out = net.forward();
+            } catch (const cv::Exception&) {
+                out.release();
+            }
+
+            // Model ONNX cố định batch = 1 -> chuyển hẳn sang forward từng ảnh
+            if (out.empty() || out.size[0] != n) {
+                printf("[FaceNet] Model does not support batch %d, falling back to batch 1\n", n);
+                max_batch = 1;
+                out.release();
+            }
+        }
+
+        if (out.empty()) {
+            resizeBlob(1);
+            for (int k = 0; k < n; k++) {
+                if (!fillBlob(face_imgs[idx[k]], 0)) continue;
+                net.setInput(input_blob);
+                results[idx[k]] = l2Normalize(net.forward().reshape(1, 1));
+            }
+            return;
+        }
+
+        cv::Mat rows = out.reshape(1, n);   // n x D
+        for (int k = 0; k < n; k++) {
+            results[idx[k]] = l2Normalize(rows.row(k));
+        }
+    }
+
+    static cv::Mat l2Normalize(const cv::Mat& emb) {
+        double norm = cv::norm(emb, cv::NORM_L2);
+        if (norm > 1e-6) return emb / norm;
+        return emb.clone();
+    }
+
     // ---------------------------
     // Data Augmentation cho đăng ký
     // ---------------------------
@@ -142,6 +231,12 @@ public:
             net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
             net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
 
+            // Forward thử 1 ảnh 0 để biết số chiều embedding (model FP32 hoặc INT8 QDQ đều được)
+            int probe_size[] = {1, 3, 112, 112};
+            cv::Mat probe(4, probe_size, CV_32F, cv::Scalar(0));
+            net.setInput(probe);
+            emb_dim = (int)net.forward().total();
+
             is_loaded = true;
             std::cout << "[FaceNet] Model loaded: " << modelPath << std::endl;
 
@@ -159,21 +254,11 @@ public:
             return cv::Mat();
         }
 
-        // Preprocessing chuẩn
-        cv::Mat processed = preprocessFaceStandard(face_img);
-        if (processed.empty()) return cv::Mat();
-
-        // Tạo blob (CHÚ Ý: swapRB = false vì đã convert RGB ở trên)
-        cv::Mat blob = cv::dnn::blobFromImage(
-            processed,
-            1.0,              // scale = 1.0 vì đã normalize rồi
-            cv::Size(112, 112),
-            cv::Scalar(0, 0, 0), // mean = 0 vì đã trừ 127.5
-            false,            // swapRB = false (đã RGB)
-            false             // crop
-        );
-
-        net.setInput(blob);
+        // Preprocessing chuẩn (resize + BGR->RGB + normalize + HWC->CHW) ghi thẳng vào input_blob
+        resizeBlob(1);
+        if (!fillBlob(face_img, 0)) return cv::Mat();
+
+        net.setInput(input_blob);
         cv::Mat emb = net.forward();
         
         // L2 Normalization (QUAN TRỌNG!)
@@ -188,19 +273,61 @@ public:
         return emb_normalized;
     }
 
+    // ---------------------------
+    // Lấy Embedding theo batch: 1 blob NCHW + 1 lần forward cho mỗi batch
+    // Kết quả cùng thứ tự với đầu vào (ảnh rỗng -> Mat rỗng)
+    // ---------------------------
+    std::vector<cv::Mat> getEmbeddings(const std::vector<cv::Mat>& face_imgs) {
+        std::vector<cv::Mat> results(face_imgs.size());
+        if (!is_loaded || net.empty()) return results;
+
+        std::vector<size_t> batch_idx;
+
+        for (size_t i = 0; i < face_imgs.size(); i++) {
+            if (face_imgs[i].empty()) continue;
+            batch_idx.push_back(i);
+
+            if ((int)batch_idx.size() >= max_batch) {
+                forwardBatch(face_imgs, batch_idx, results);
+                batch_idx.clear();
+            }
+        }
+        if (!batch_idx.empty()) forwardBatch(face_imgs, batch_idx, results);
+
+        return results;
+    }
+
+    void setMaxBatch(int n) { max_batch = std::max(1, n); }
+    int getMaxBatch() const { return max_batch; }
+
     // ---------------------------
     // Đăng ký chủ nhân với augmentation
     // ---------------------------
     cv::Mat registerOwner(const std::vector<cv::Mat>& face_samples) {
-        if (face_samples.empty()) return cv::Mat();
+        std::vector<EnrollSample> samples(face_samples.size());
+        std::vector<cv::Mat> embs = getEmbeddings(face_samples);
+        for (size_t i = 0; i < face_samples.size(); i++) {
+            samples[i].face = face_samples[i];
+            samples[i].embedding = embs[i];
+            samples[i].quality = assessFaceQuality(face_samples[i]);
+        }
+        return registerOwner(samples);
+    }
+
+    // Dùng lại embedding + quality đã tính lúc thu mẫu:
+    // ảnh gốc không forward lại, chỉ forward 6 biến thể augmentation
+    cv::Mat registerOwner(const std::vector<EnrollSample>& samples) {
+        if (samples.empty()) return cv::Mat();
 
+        std::vector<cv::Mat> all_faces;
+        std::vector<float> face_quality;
         std::vector<cv::Mat> all_embeddings;
         std::vector<float> quality_scores;
 
-        printf("[FaceNet] Processing %zu samples...\n", face_samples.size());
+        printf("[FaceNet] Processing %zu samples...\n", samples.size());
 
-        for (size_t i = 0; i < face_samples.size(); i++) {
-            float quality = assessFaceQuality(face_samples[i]);
+        for (size_t i = 0; i < samples.size(); i++) {
+            float quality = samples[i].quality;
             
             // Chỉ lấy mẫu chất lượng cao
             if (quality < 0.4f) {
@@ -208,15 +335,26 @@ public:
                 continue;
             }
 
-            // Augmentation: tạo thêm 7 biến thể
-            std::vector<cv::Mat> augmented = augmentFace(face_samples[i]);
-            
-            for (const auto& aug_face : augmented) {
-                cv::Mat emb = getEmbedding(aug_face);
-                if (!emb.empty() && emb.total() > 0) {
-                    all_embeddings.push_back(emb);
-                    quality_scores.push_back(quality);
-                }
+            // Augmentation: tạo thêm 7 biến thể (phần tử 0 là ảnh gốc)
+            std::vector<cv::Mat> augmented = augmentFace(samples[i].face);
+            size_t first = 0;
+            if (!samples[i].embedding.empty()) {
+                all_embeddings.push_back(samples[i].embedding);
+                quality_scores.push_back(quality);
+                first = 1;
+            }
+            for (size_t k = first; k < augmented.size(); k++) {
+                all_faces.push_back(augmented[k]);
+                face_quality.push_back(quality);
+            }
+        }
+
+        // Forward theo batch thay vì từng ảnh
+        std::vector<cv::Mat> embs = getEmbeddings(all_faces);
+        for (size_t i = 0; i < embs.size(); i++) {
+            if (!embs[i].empty() && embs[i].total() > 0) {
+                all_embeddings.push_back(embs[i]);
+                quality_scores.push_back(face_quality[i]);
             }
         }
 
@@ -226,7 +364,7 @@ public:
         }
 
         printf("[FaceNet] Generated %zu embeddings from %zu samples\n", 
-               all_embeddings.size(), face_samples.size());
+               all_embeddings.size(), samples.size());
 
         // Tính trung bình có trọng số
         cv::Mat avg_embedding = cv::Mat::zeros(all_embeddings[0].size(), CV_32F);
@@ -314,6 +452,7 @@ public:
     }
 
     bool isLoaded() const { return is_loaded; }
+    int getEmbeddingDim() const { return emb_dim; }
     float checkQuality(const cv::Mat& face_img) { return assessFaceQuality(face_img); }
 };
 
@@ -0,0 +1,58 @@
+#include "frame_channel.h"
+
+void frame_channel_init(FrameChannel* c) {
+    c->frame.reset();
+    c->closed = 0;
+    c->published = 0;
+    c->overwritten = 0;
+    pthread_mutex_init(&c->mutex, NULL);
+    pthread_cond_init(&c->cond, NULL);
+}
+
+void frame_channel_free(FrameChannel* c) {
+    c->frame.reset();
+    pthread_cond_destroy(&c->cond);
+    pthread_mutex_destroy(&c->mutex);
+}
+
+void frame_channel_publish(FrameChannel* c, const FrameHandle& frame) {
+    pthread_mutex_lock(&c->mutex);
+    if (!c->frame.empty()) c->overwritten++;
+    c->frame = frame;
+    c->published++;
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&c->mutex);
+}
+
+int frame_channel_wait(FrameChannel* c, FrameHandle* frame_out) {
+    pthread_mutex_lock(&c->mutex);
+    while (!c->closed && c->frame.empty()) {
+        pthread_cond_wait(&c->cond, &c->mutex);
+    }
+    int ok = !c->frame.empty();     // Đóng nhưng còn frame -> vẫn trả frame cuối
+    if (ok) *frame_out = std::move(c->frame);
+    pthread_mutex_unlock(&c->mutex);
+    return ok;
+}
+
+int frame_channel_poll(FrameChannel* c, FrameHandle* frame_out) {
+    pthread_mutex_lock(&c->mutex);
+    int r = c->frame.empty() ? (c->closed ? -1 : 0) : 1;
+    if (r > 0) *frame_out = std::move(c->frame);
+    pthread_mutex_unlock(&c->mutex);
+    return r;
+}
+
+void frame_channel_close(FrameChannel* c) {
+    pthread_mutex_lock(&c->mutex);
+    c->closed = 1;
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->mutex);
+}
+
+uint64_t frame_channel_overwritten(FrameChannel* c) {
+    pthread_mutex_lock(&c->mutex);
+    uint64_t n = c->overwritten;
+    pthread_mutex_unlock(&c->mutex);
+    return n;
+}
@@ -0,0 +1,36 @@
+#ifndef FRAME_CHANNEL_H
+#define FRAME_CHANNEL_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "frame_pool.h"
+
+// Hộp thư 1 frame giữa Camera và AI (frame mới nhất thắng):
+// - Camera publish không bao giờ chờ, frame AI chưa kịp lấy bị thay bằng frame mới
+// - AI ngủ trên condvar tới khi có frame mới hoặc kênh bị đóng (không poll)
+typedef struct {
+    FrameHandle frame;          // Frame mới nhất chưa lấy (rỗng = chưa có)
+    int closed;
+    uint64_t published;
+    uint64_t overwritten;       // Số frame bị thay trước khi AI kịp lấy
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} FrameChannel;
+
+void frame_channel_init(FrameChannel* c);
+void frame_channel_free(FrameChannel* c);
+
+// Producer: đặt frame mới, đánh thức consumer
+void frame_channel_publish(FrameChannel* c, const FrameHandle& frame);
+// Consumer: chờ frame mới. Trả về 1 nếu có frame, 0 nếu kênh đã đóng
+int  frame_channel_wait(FrameChannel* c, FrameHandle* frame_out);
+// Consumer: lấy frame nếu có, không chờ. 1 = có frame, 0 = chưa có, -1 = kênh đã đóng và hết frame
+int  frame_channel_poll(FrameChannel* c, FrameHandle* frame_out);
+// Đóng kênh: consumer đang chờ thoát ra với kết quả 0
+void frame_channel_close(FrameChannel* c);
+
+uint64_t frame_channel_overwritten(FrameChannel* c);
+
+extern FrameChannel ai_channel;
+
+#endif
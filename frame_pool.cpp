@@ -0,0 +1,61 @@
+#include <time.h>
+#include "frame_pool.h"
+
+void frame_pool_init(FramePool* p) {
+    pthread_mutex_init(&p->mutex, NULL);
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        PooledFrame* f = &p->frames[i];
+        f->mat.create(LCD_HEIGHT, LCD_WIDTH, CV_8UC3);
+        f->yuyv.create(LCD_HEIGHT, LCD_WIDTH, CV_8UC2);
+        f->gray.create(LCD_HEIGHT, LCD_WIDTH, CV_8UC1);
+        f->format = FRAME_FORMAT_BGR;
+        f->refs = 0;
+        f->pool = p;
+        f->index = i;
+        f->capture_ns = 0;
+        f->publish_ns = 0;
+        f->seq = 0;
+        p->free_list[i] = i;
+    }
+    p->free_count = FRAME_POOL_SIZE;
+    p->exhausted = 0;
+}
+
+FrameHandle frame_pool_acquire(FramePool* p) {
+    pthread_mutex_lock(&p->mutex);
+    if (p->free_count == 0) {
+        pthread_mutex_unlock(&p->mutex);
+        p->exhausted++;
+        return FrameHandle();
+    }
+    PooledFrame* f = &p->frames[p->free_list[--p->free_count]];
+    pthread_mutex_unlock(&p->mutex);
+
+    f->refs = 1;
+    return FrameHandle(f);
+}
+
+int frame_pool_available(FramePool* p) {
+    pthread_mutex_lock(&p->mutex);
+    int n = p->free_count;
+    pthread_mutex_unlock(&p->mutex);
+    return n;
+}
+
+void FrameHandle::reset() {
+    if (!f) return;
+    // Người giữ cuối cùng trả buffer về pool
+    if (--f->refs == 0) {
+        FramePool* p = f->pool;
+        pthread_mutex_lock(&p->mutex);
+        p->free_list[p->free_count++] = f->index;
+        pthread_mutex_unlock(&p->mutex);
+    }
+    f = NULL;
+}
+
+uint64_t frame_clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
@@ -0,0 +1,93 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <opencv4/opencv2/opencv.hpp>
+#include <atomic>
+#include <pthread.h>
+#include <stdint.h>
+#include "config.h"
+
+// Pool frame 320x240x3 cấp phát sẵn, dùng chung giữa Camera / AI / LCD qua handle.
+// Buffer tự trả về pool khi handle cuối cùng bị hủy -> không malloc mỗi frame.
+struct FramePool;
+
+// Định dạng nội dung frame: BGR (OpenCV / replay) hoặc YUYV (V4L2 trực tiếp)
+enum FrameFormat {
+    FRAME_FORMAT_BGR = 0,   // mat hợp lệ
+    FRAME_FORMAT_YUYV,      // yuyv + gray (kênh Y) hợp lệ, mat không dùng
+};
+
+struct PooledFrame {
+    cv::Mat mat;
+    cv::Mat yuyv;           // CV_8UC2: Y0 U Y1 V
+    cv::Mat gray;           // CV_8UC1: kênh Y tách từ yuyv
+    FrameFormat format;
+    std::atomic<int> refs;
+    FramePool* pool;
+    int index;
+    uint64_t capture_ns;    // Thời điểm camera lấy frame (frame_clock_ns)
+    uint64_t publish_ns;    // Thời điểm giao cho LCD / AI (đo thời gian chờ trong hàng đợi)
+    uint64_t seq;           // Số thứ tự frame camera (nhảy số = frame bị bỏ)
+};
+
+struct FramePool {
+    PooledFrame frames[FRAME_POOL_SIZE];
+    int free_list[FRAME_POOL_SIZE];
+    int free_count;
+    pthread_mutex_t mutex;
+    std::atomic<uint64_t> exhausted;    // Số lần xin buffer nhưng pool đã hết
+};
+
+// Handle đếm tham chiếu (giống cv::Mat nhưng bộ nhớ thuộc pool)
+class FrameHandle {
+public:
+    FrameHandle() : f(NULL) {}
+    explicit FrameHandle(PooledFrame* frame) : f(frame) {}
+    FrameHandle(const FrameHandle& o) : f(o.f) { if (f) f->refs++; }
+    FrameHandle(FrameHandle&& o) : f(o.f) { o.f = NULL; }
+    ~FrameHandle() { reset(); }
+
+    FrameHandle& operator=(const FrameHandle& o) {
+        if (o.f) o.f->refs++;
+        reset();
+        f = o.f;
+        return *this;
+    }
+    FrameHandle& operator=(FrameHandle&& o) {
+        if (this != &o) {
+            reset();
+            f = o.f;
+            o.f = NULL;
+        }
+        return *this;
+    }
+
+    void reset();
+    bool empty() const { return f == NULL; }
+    cv::Mat& mat() const { return f->mat; }
+    cv::Mat& yuyv() const { return f->yuyv; }
+    cv::Mat& gray() const { return f->gray; }
+    FrameFormat format() const { return f->format; }
+    void setFormat(FrameFormat fmt) { f->format = fmt; }
+    uint64_t captureNs() const { return f->capture_ns; }
+    void setCaptureNs(uint64_t ns) { f->capture_ns = ns; }
+    uint64_t publishNs() const { return f->publish_ns; }
+    void setPublishNs(uint64_t ns) { f->publish_ns = ns; }
+    uint64_t seq() const { return f->seq; }
+    void setSeq(uint64_t s) { f->seq = s; }
+
+private:
+    PooledFrame* f;
+};
+
+void frame_pool_init(FramePool* p);
+// Lấy buffer trống (handle rỗng nếu pool đã hết)
+FrameHandle frame_pool_acquire(FramePool* p);
+int frame_pool_available(FramePool* p);
+
+// Đồng hồ monotonic (ns) dùng để đo độ trễ từ lúc chụp
+uint64_t frame_clock_ns();
+
+extern FramePool frame_pool;
+
+#endif
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lcd_delta.h"
+#include "lcd_driver.h"
+
+#define FRAME_BYTES (LCD_WIDTH * LCD_HEIGHT * 2)
+#define ROW_BYTES   (LCD_WIDTH * 2)
+
+int lcd_delta_init(LcdDelta* d) {
+    memset(d, 0, sizeof(*d));
+    d->prev = (uint8_t*)malloc(FRAME_BYTES);
+    d->band = (uint8_t*)malloc(ROW_BYTES * LCD_TILE_H);
+    if (!d->prev || !d->band) {
+        lcd_delta_free(d);
+        return 0;
+    }
+    return 1;
+}
+
+void lcd_delta_free(LcdDelta* d) {
+    free(d->prev);
+    free(d->band);
+    d->prev = NULL;
+    d->band = NULL;
+}
+
+void lcd_delta_invalidate(LcdDelta* d) {
+    d->has_prev = 0;
+}
+
+// Tổng sai khác |dR|+|dG|+|dB| (đơn vị 565) của từng tile trong 1 dải
+static void diff_band(const uint8_t* cur, const uint8_t* prev, int rows, uint32_t* sums) {
+    memset(sums, 0, sizeof(uint32_t) * LCD_TILES_X);
+    for (int y = 0; y < rows; y++) {
+        const uint8_t* a = cur + y * ROW_BYTES;
+        const uint8_t* b = prev + y * ROW_BYTES;
+        for (int tx = 0; tx < LCD_TILES_X; tx++) {
+            int x0 = tx * LCD_TILE_W;
+            int x1 = (x0 + LCD_TILE_W < LCD_WIDTH) ? x0 + LCD_TILE_W : LCD_WIDTH;
+            uint32_t s = 0;
+            for (int x = x0; x < x1; x++) {
+                int va = (a[2*x] << 8) | a[2*x + 1];
+                int vb = (b[2*x] << 8) | b[2*x + 1];
+                if (va == vb) continue;
+                s += abs((va >> 11) - (vb >> 11))
+                   + abs(((va >> 5) & 0x3F) - ((vb >> 5) & 0x3F))
+                   + abs((va & 0x1F) - (vb & 0x1F));
+            }
+            sums[tx] += s;
+        }
+    }
+}
+
+int lcd_delta_send(LcdDelta* d, const uint8_t* frame, const uint32_t* force) {
+    d->stat_frames++;
+
+    // Frame đầu hoặc tới chu kỳ refresh: gửi full
+    if (!d->has_prev || ++d->frames_since_full >= LCD_FULL_REFRESH) {
+        memcpy(d->prev, frame, FRAME_BYTES);
+        lcd_push_region(0, 0, LCD_WIDTH - 1, LCD_HEIGHT - 1, frame, FRAME_BYTES);
+        d->has_prev = 1;
+        d->frames_since_full = 0;
+        d->stat_tiles_sent += LCD_TILES_X * LCD_TILES_Y;
+        d->stat_windows++;
+        d->stat_bytes_sent += FRAME_BYTES;
+        return LCD_TILES_X * LCD_TILES_Y;
+    }
+
+    int tiles_sent = 0;
+    uint32_t sums[LCD_TILES_X];
+
+    for (int ty = 0; ty < LCD_TILES_Y; ty++) {
+        int y0 = ty * LCD_TILE_H;
+        int rows = (y0 + LCD_TILE_H < LCD_HEIGHT) ? LCD_TILE_H : LCD_HEIGHT - y0;
+        diff_band(frame + y0 * ROW_BYTES, d->prev + y0 * ROW_BYTES, rows, sums);
+        uint32_t forced = force ? force[ty] : 0;
+
+        // Gộp các tile thay đổi liền nhau trên cùng hàng thành 1 cửa sổ
+        int tx = 0;
+        while (tx < LCD_TILES_X) {
+            int x0 = tx * LCD_TILE_W;
+            int w0 = (x0 + LCD_TILE_W < LCD_WIDTH) ? LCD_TILE_W : LCD_WIDTH - x0;
+            if (!(forced >> tx & 1) && sums[tx] <= (uint32_t)(LCD_TILE_THRESHOLD * w0 * rows)) {
+                tx++;
+                continue;
+            }
+
+            int run_end = tx + 1;
+            while (run_end < LCD_TILES_X) {
+                int xs = run_end * LCD_TILE_W;
+                int ws = (xs + LCD_TILE_W < LCD_WIDTH) ? LCD_TILE_W : LCD_WIDTH - xs;
+                if (!(forced >> run_end & 1) && sums[run_end] <= (uint32_t)(LCD_TILE_THRESHOLD * ws * rows)) break;
+                run_end++;
+            }
+
+            int x1 = (run_end * LCD_TILE_W < LCD_WIDTH) ? run_end * LCD_TILE_W : LCD_WIDTH;
+            int run_bytes = (x1 - x0) * 2;
+
+            // Cập nhật prev + gom các dòng của cửa sổ vào band
+            uint8_t* out = d->band;
+            for (int y = 0; y < rows; y++) {
+                const uint8_t* src = frame + (y0 + y) * ROW_BYTES + x0 * 2;
+                memcpy(d->prev + (y0 + y) * ROW_BYTES + x0 * 2, src, run_bytes);
+                memcpy(out, src, run_bytes);
+                out += run_bytes;
+            }
+            lcd_push_region(x0, y0, x1 - 1, y0 + rows - 1, d->band, run_bytes * rows);
+
+            tiles_sent += run_end - tx;
+            d->stat_windows++;
+            d->stat_bytes_sent += run_bytes * rows;
+            tx = run_end;
+        }
+    }
+
+    d->stat_tiles_sent += tiles_sent;
+    return tiles_sent;
+}
+
+void lcd_delta_print_stats(LcdDelta* d) {
+    if (d->stat_frames == 0) return;
+
+    uint64_t full_bytes = (uint64_t)d->stat_frames * FRAME_BYTES;
+    uint64_t saved = full_bytes - d->stat_bytes_sent;
+    printf("[LCD Delta] %u frames | tiles/frame: %.1f/%d | windows/frame: %.1f | saved: %.1f KB/frame (%.0f%%)\n",
+           d->stat_frames,
+           (double)d->stat_tiles_sent / d->stat_frames, LCD_TILES_X * LCD_TILES_Y,
+           (double)d->stat_windows / d->stat_frames,
+           saved / 1024.0 / d->stat_frames,
+           100.0 * saved / full_bytes);
+
+    d->stat_frames = 0;
+    d->stat_tiles_sent = 0;
+    d->stat_windows = 0;
+    d->stat_bytes_sent = 0;
+}
@@ -0,0 +1,39 @@
+#ifndef LCD_DELTA_H
+#define LCD_DELTA_H
+
+#include <stdint.h>
+#include "config.h"
+
+#define LCD_TILES_X ((LCD_WIDTH  + LCD_TILE_W - 1) / LCD_TILE_W)
+#define LCD_TILES_Y ((LCD_HEIGHT + LCD_TILE_H - 1) / LCD_TILE_H)
+
+// Cập nhật LCD theo tile: giữ lại frame RGB565 đã gửi lần trước,
+// so sánh từng tile và chỉ gửi các tile thay đổi.
+typedef struct {
+    uint8_t* prev;          // Nội dung LCD hiện tại (frame đã gửi)
+    uint8_t* band;          // Buffer gom 1 dải tile trước khi gửi SPI
+    int has_prev;
+    int frames_since_full;
+
+    // Thống kê (reset sau mỗi lần in)
+    uint32_t stat_frames;
+    uint64_t stat_tiles_sent;
+    uint64_t stat_windows;
+    uint64_t stat_bytes_sent;
+} LcdDelta;
+
+int  lcd_delta_init(LcdDelta* d);
+void lcd_delta_free(LcdDelta* d);
+
+// Gửi frame (LCD_WIDTH x LCD_HEIGHT, RGB565 Big Endian) - trả về số tile đã gửi.
+// force (NULL = không có): LCD_TILES_Y hàng bitmask, bit tx = tile luôn gửi dù sai khác dưới ngưỡng
+// (vùng overlay vẽ: chữ mảnh có thể không đủ ngưỡng)
+int  lcd_delta_send(LcdDelta* d, const uint8_t* frame, const uint32_t* force);
+
+// Đánh dấu toàn màn hình cần gửi lại ở frame kế tiếp
+void lcd_delta_invalidate(LcdDelta* d);
+
+// In thống kê và reset bộ đếm
+void lcd_delta_print_stats(LcdDelta* d);
+
+#endif
@@ -1,21 +1,113 @@
+#include <stddef.h>
+#include <string.h>
 #include "lcd_driver.h"
 
+// Transport hiện tại (mặc định bcm2835)
+static LcdTransport* transport = NULL;
+
+void lcd_set_transport(LcdTransport* t) {
+    transport = t;
+}
+
+LcdTransport* lcd_get_transport() {
+    if (!transport) transport = lcd_transport_bcm2835();
+    return transport;
+}
+
 void lcd_cmd(uint8_t cmd) {
-    bcm2835_gpio_write(PIN_DC, LOW);
-    bcm2835_spi_transfer(cmd);
+    LcdTransport* t = lcd_get_transport();
+    lcd_transport_write(t, LOW, &cmd, 1);
 }
 
 void lcd_dat(uint8_t dat) {
-    bcm2835_gpio_write(PIN_DC, HIGH);
-    bcm2835_spi_transfer(dat);
+    LcdTransport* t = lcd_get_transport();
+    lcd_transport_write(t, HIGH, &dat, 1);
+}
+
+void lcd_stream_cmd(LcdCmdStream* s, uint8_t cmd, const uint8_t* params, uint32_t n) {
+    if (s->len + 1 + n > LCD_CMD_STREAM_MAX) lcd_stream_flush(s);
+    if (1 + n > LCD_CMD_STREAM_MAX) {
+        // Khối tham số dài hơn cả buffer: stream đã flush, gửi thẳng lệnh rồi tham số (giữ thứ tự)
+        LcdTransport* t = lcd_get_transport();
+        lcd_transport_write(t, LOW, &cmd, 1);
+        lcd_transport_write(t, HIGH, params, n);
+        return;
+    }
+    s->buf[s->len] = cmd;
+    s->dc[s->len++] = LOW;
+    if (n == 0) return;
+    memcpy(s->buf + s->len, params, n);
+    memset(s->dc + s->len, HIGH, n);
+    s->len += n;
+}
+
+void lcd_stream_flush(LcdCmdStream* s) {
+    LcdTransport* t = lcd_get_transport();
+    uint32_t i = 0;
+    while (i < s->len) {
+        uint32_t j = i + 1;
+        while (j < s->len && s->dc[j] == s->dc[i]) j++;
+        lcd_transport_write(t, s->dc[i], s->buf + i, j - i);
+        i = j;
+    }
+    s->len = 0;
+}
+
+// 0x2A / 0x2B / 0x2C trong 1 stream: 5 lần ghi thay vì 11 lần ghi 1 byte
+static void stream_window(LcdCmdStream* s, int x1, int y1, int x2, int y2) {
+    const uint8_t cols[4] = { (uint8_t)(x1 >> 8), (uint8_t)x1, (uint8_t)(x2 >> 8), (uint8_t)x2 };
+    const uint8_t rows[4] = { (uint8_t)(y1 >> 8), (uint8_t)y1, (uint8_t)(y2 >> 8), (uint8_t)y2 };
+    lcd_stream_cmd(s, 0x2A, cols, 4);
+    lcd_stream_cmd(s, 0x2B, rows, 4);
+    lcd_stream_cmd(s, 0x2C, NULL, 0);
 }
 
 void lcd_set_window(int x1, int y1, int x2, int y2) {
-    lcd_cmd(0x2A); lcd_dat(x1>>8); lcd_dat(x1); lcd_dat(x2>>8); lcd_dat(x2);
-    lcd_cmd(0x2B); lcd_dat(y1>>8); lcd_dat(y1); lcd_dat(y2>>8); lcd_dat(y2);
-    lcd_cmd(0x2C);
+    LcdCmdStream s;
+    s.len = 0;
+    stream_window(&s, x1, y1, x2, y2);
+    lcd_stream_flush(&s);
 }
 
+void lcd_push_region(int x1, int y1, int x2, int y2, const uint8_t* data, uint32_t len) {
+    lcd_set_window(x1, y1, x2, y2);
+
+    // Pixel nối tiếp 0x2C cùng DC = HIGH: transport không phải đổi chân DC
+    LcdTransport* t = lcd_get_transport();
+    lcd_transport_write(t, HIGH, data, len);
+}
+
+// --- CHUỖI KHỞI TẠO ILI9341 ---
+typedef struct {
+    uint8_t cmd;
+    uint8_t n;              // Số byte tham số
+    uint8_t params[15];
+    uint8_t delay_ms;       // Chờ sau lệnh (0 = gửi tiếp luôn, gom chung 1 stream)
+} LcdInitStep;
+
+static constexpr LcdInitStep INIT_SEQ[] = {
+    { 0x01, 0,  { 0 }, 120 },                           // Software reset
+    { 0x28, 0,  { 0 }, 0 },                             // Display off
+    { 0xCF, 3,  { 0x00, 0x83, 0x30 }, 0 },
+    { 0xED, 4,  { 0x64, 0x03, 0x12, 0x81 }, 0 },
+    { 0xE8, 3,  { 0x85, 0x01, 0x79 }, 0 },
+    { 0xCB, 5,  { 0x39, 0x2C, 0x00, 0x34, 0x02 }, 0 },
+    { 0xF7, 1,  { 0x20 }, 0 },
+    { 0xEA, 2,  { 0x00, 0x00 }, 0 },
+    { 0xC0, 1,  { 0x26 }, 0 },                          // Power control 1
+    { 0xC1, 1,  { 0x11 }, 0 },                          // Power control 2
+    { 0xC5, 2,  { 0x35, 0x3E }, 0 },                    // VCOM
+    { 0xC7, 1,  { 0xBE }, 0 },
+    { 0x36, 1,  { 0x28 }, 0 },                          // Hướng quét (MADCTL)
+    { 0x3A, 1,  { 0x55 }, 0 },                          // 16 bit / pixel
+    { 0xB1, 2,  { 0x00, 0x1B }, 0 },                    // Frame rate
+    { 0x26, 1,  { 0x01 }, 0 },                          // Gamma curve
+    { 0xE0, 15, { 0x1F, 0x1A, 0x18, 0x0A, 0x0F, 0x06, 0x45, 0x87, 0x32, 0x0A, 0x07, 0x02, 0x07, 0x05, 0x00 }, 0 },
+    { 0xE1, 15, { 0x00, 0x25, 0x27, 0x05, 0x10, 0x09, 0x3A, 0x78, 0x4D, 0x05, 0x18, 0x0D, 0x38, 0x3A, 0x1F }, 0 },
+    { 0x11, 0,  { 0 }, 120 },                           // Sleep out
+    { 0x29, 0,  { 0 }, 20 },                            // Display on
+};
+
 void lcd_init_full() {
     // Bật đèn nền
     bcm2835_gpio_write(PIN_LED, HIGH);
@@ -24,26 +116,15 @@ void lcd_init_full() {
     bcm2835_gpio_write(PIN_RST, LOW); bcm2835_delay(20);
     bcm2835_gpio_write(PIN_RST, HIGH); bcm2835_delay(150);
 
-    lcd_cmd(0x01); bcm2835_delay(120);
-    lcd_cmd(0x28);
-    lcd_cmd(0xCF); lcd_dat(0x00); lcd_dat(0x83); lcd_dat(0x30);
-    lcd_cmd(0xED); lcd_dat(0x64); lcd_dat(0x03); lcd_dat(0x12); lcd_dat(0x81);
-    lcd_cmd(0xE8); lcd_dat(0x85); lcd_dat(0x01); lcd_dat(0x79);
-    lcd_cmd(0xCB); lcd_dat(0x39); lcd_dat(0x2C); lcd_dat(0x00); lcd_dat(0x34); lcd_dat(0x02);
-    lcd_cmd(0xF7); lcd_dat(0x20);
-    lcd_cmd(0xEA); lcd_dat(0x00); lcd_dat(0x00);
-    lcd_cmd(0xC0); lcd_dat(0x26);
-    lcd_cmd(0xC1); lcd_dat(0x11);
-    lcd_cmd(0xC5); lcd_dat(0x35); lcd_dat(0x3E);
-    lcd_cmd(0xC7); lcd_dat(0xBE);
-    
-    lcd_cmd(0x36); lcd_dat(0x28); 
-    
-    lcd_cmd(0x3A); lcd_dat(0x55);
-    lcd_cmd(0xB1); lcd_dat(0x00); lcd_dat(0x1B);
-    lcd_cmd(0x26); lcd_dat(0x01);
-    lcd_cmd(0xE0); lcd_dat(0x1F); lcd_dat(0x1A); lcd_dat(0x18); lcd_dat(0x0A); lcd_dat(0x0F); lcd_dat(0x06); lcd_dat(0x45); lcd_dat(0x87); lcd_dat(0x32); lcd_dat(0x0A); lcd_dat(0x07); lcd_dat(0x02); lcd_dat(0x07); lcd_dat(0x05); lcd_dat(0x00);
-    lcd_cmd(0xE1); lcd_dat(0x00); lcd_dat(0x25); lcd_dat(0x27); lcd_dat(0x05); lcd_dat(0x10); lcd_dat(0x09); lcd_dat(0x3A); lcd_dat(0x78); lcd_dat(0x4D); lcd_dat(0x05); lcd_dat(0x18); lcd_dat(0x0D); lcd_dat(0x38); lcd_dat(0x3A); lcd_dat(0x1F);
-    lcd_cmd(0x11); bcm2835_delay(120);
-    lcd_cmd(0x29); bcm2835_delay(20);
-}
\ No newline at end of file
+    LcdCmdStream s;
+    s.len = 0;
+    for (size_t i = 0; i < sizeof(INIT_SEQ) / sizeof(INIT_SEQ[0]); i++) {
+        const LcdInitStep& step = INIT_SEQ[i];
+        lcd_stream_cmd(&s, step.cmd, step.params, step.n);
+        if (step.delay_ms) {
+            lcd_stream_flush(&s);
+            bcm2835_delay(step.delay_ms);
+        }
+    }
+    lcd_stream_flush(&s);
+}
@@ -3,10 +3,31 @@
 
 #include <stdint.h>
 #include "config.h"
+#include "lcd_transport.h"
+
+// Chọn transport (NULL = bcm2835). Gọi trước khi khởi tạo các luồng.
+void lcd_set_transport(LcdTransport* t);
+LcdTransport* lcd_get_transport();
+
+// Bộ mã hóa chuỗi lệnh: gom lệnh + tham số vào 1 buffer, khi flush mỗi đoạn liền nhau cùng DC
+// (mã lệnh / khối tham số) là 1 lần ghi transport -> DC chỉ đổi ở ranh giới lệnh / dữ liệu.
+// Lệnh có hơn LCD_CMD_STREAM_MAX - 1 byte tham số được gửi thẳng ngay sau phần đã gom
+#define LCD_CMD_STREAM_MAX 64
+
+typedef struct {
+    uint8_t buf[LCD_CMD_STREAM_MAX];
+    uint8_t dc[LCD_CMD_STREAM_MAX];     // LOW = byte lệnh, HIGH = byte dữ liệu
+    uint32_t len;
+} LcdCmdStream;
+
+void lcd_stream_cmd(LcdCmdStream* s, uint8_t cmd, const uint8_t* params, uint32_t n);
+void lcd_stream_flush(LcdCmdStream* s);
 
 void lcd_cmd(uint8_t cmd);
 void lcd_dat(uint8_t dat);
 void lcd_init_full();
 void lcd_set_window(int x1, int y1, int x2, int y2);
+// Gửi 1 vùng RGB565 (Big Endian) lên LCD
+void lcd_push_region(int x1, int y1, int x2, int y2, const uint8_t* data, uint32_t len);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <string.h>
+#include <opencv4/opencv2/opencv.hpp>
+#include "lcd_overlay.h"
+
+static int build_font(OverlayFont* f, double scale, int thickness) {
+    const int face = cv::FONT_HERSHEY_SIMPLEX;
+    int base = 0;
+    cv::Size full = cv::getTextSize("Ag|jy", face, scale, thickness, &base);
+
+    // Nét dày tràn ra ngoài hộp chữ -> chừa lề thickness mỗi phía
+    int max_w = 0;
+    for (int c = OVERLAY_FIRST_CHAR; c <= OVERLAY_LAST_CHAR; c++) {
+        std::string one(1, (char)c), two(2, (char)c);
+        int w1 = cv::getTextSize(one, face, scale, thickness, &base).width;
+        int w2 = cv::getTextSize(two, face, scale, thickness, &base).width;
+        f->advance[c - OVERLAY_FIRST_CHAR] = w2 - w1;   // Bước bút đúng như putText với chuỗi dài
+        if (w1 > max_w) max_w = w1;
+    }
+    f->origin_x = thickness + 1;
+    f->origin_y = full.height + thickness + 1;
+    f->cell_w = max_w + 2 * (thickness + 1);
+    f->cell_h = full.height + base + 2 * (thickness + 1);
+    f->mask = (uint8_t*)calloc((size_t)OVERLAY_GLYPHS * f->cell_w * f->cell_h, 1);
+    if (!f->mask) return 0;
+
+    cv::Mat cell(f->cell_h, f->cell_w, CV_8UC1);
+    for (int c = OVERLAY_FIRST_CHAR; c <= OVERLAY_LAST_CHAR; c++) {
+        cell.setTo(0);
+        cv::putText(cell, std::string(1, (char)c), cv::Point(f->origin_x, f->origin_y),
+                    face, scale, cv::Scalar(1), thickness);
+        memcpy(f->mask + (size_t)(c - OVERLAY_FIRST_CHAR) * f->cell_w * f->cell_h, cell.data,
+               (size_t)f->cell_w * f->cell_h);
+    }
+    return 1;
+}
+
+int lcd_overlay_init(LcdOverlay* o) {
+    memset(o, 0, sizeof(*o));
+    int ok = build_font(&o->fonts[OVERLAY_FONT_MESSAGE], 0.6, 2) &&
+             build_font(&o->fonts[OVERLAY_FONT_STATUS], 0.5, 1);
+    if (!ok) lcd_overlay_free(o);
+    return ok;
+}
+
+void lcd_overlay_free(LcdOverlay* o) {
+    for (int i = 0; i < OVERLAY_FONT_COUNT; i++) {
+        free(o->fonts[i].mask);
+        o->fonts[i].mask = NULL;
+    }
+}
+
+void lcd_overlay_begin(LcdOverlay* o) {
+    memcpy(o->prev_touched, o->touched, sizeof(o->touched));
+    memset(o->touched, 0, sizeof(o->touched));
+}
+
+void lcd_overlay_dirty(const LcdOverlay* o, uint32_t* rows) {
+    for (int ty = 0; ty < LCD_TILES_Y; ty++) rows[ty] = o->touched[ty] | o->prev_touched[ty];
+}
+
+// Tô 1 hình chữ nhật đặc (đã cắt theo màn hình) + đánh dấu tile
+static void fill(LcdOverlay* o, uint8_t* fb, int x0, int y0, int x1, int y1, uint16_t color) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > LCD_WIDTH) x1 = LCD_WIDTH;
+    if (y1 > LCD_HEIGHT) y1 = LCD_HEIGHT;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    for (int y = y0; y < y1; y++) {
+        uint16_t* p = (uint16_t*)(fb + (y * LCD_WIDTH + x0) * 2);
+        for (int x = x0; x < x1; x++) *p++ = color;
+    }
+
+    uint32_t bits = (uint32_t)(((uint64_t)1 << ((x1 - 1) / LCD_TILE_W + 1)) - ((uint64_t)1 << (x0 / LCD_TILE_W)));
+    for (int ty = y0 / LCD_TILE_H; ty <= (y1 - 1) / LCD_TILE_H; ty++) o->touched[ty] |= bits;
+}
+
+void lcd_overlay_rect(LcdOverlay* o, uint8_t* fb, int x, int y, int w, int h, uint16_t color, int thickness) {
+    if (w <= 0 || h <= 0) return;
+    int a = thickness / 2;              // Nửa nét nằm ngoài cạnh
+    int b = thickness - a;
+    int x2 = x + w - 1, y2 = y + h - 1;
+    fill(o, fb, x - a, y - a, x2 + b, y + b, color);          // Trên
+    fill(o, fb, x - a, y2 - a, x2 + b, y2 + b, color);        // Dưới
+    fill(o, fb, x - a, y + b, x + b, y2 - a, color);          // Trái
+    fill(o, fb, x2 - a, y + b, x2 + b, y2 - a, color);        // Phải
+}
+
+void lcd_overlay_text(LcdOverlay* o, uint8_t* fb, const char* text, int x, int baseline,
+                      OverlayFontId font, uint16_t color) {
+    const OverlayFont* f = &o->fonts[font];
+    int top = baseline - f->origin_y;
+    int row0 = top < 0 ? -top : 0;
+    int row1 = top + f->cell_h > LCD_HEIGHT ? LCD_HEIGHT - top : f->cell_h;
+    if (row0 >= row1) return;
+
+    int pen = x;
+    int min_x = LCD_WIDTH, max_x = 0;
+    for (const char* s = text; *s; s++) {
+        int c = (uint8_t)*s;
+        if (c < OVERLAY_FIRST_CHAR || c > OVERLAY_LAST_CHAR) c = '?';
+        int g = c - OVERLAY_FIRST_CHAR;
+        int left = pen - f->origin_x;
+        pen += f->advance[g];
+        if (c == ' ') continue;
+        if (left >= LCD_WIDTH) break;
+
+        int col0 = left < 0 ? -left : 0;
+        int col1 = left + f->cell_w > LCD_WIDTH ? LCD_WIDTH - left : f->cell_w;
+        if (col0 >= col1) continue;
+
+        const uint8_t* mask = f->mask + (size_t)g * f->cell_w * f->cell_h;
+        for (int r = row0; r < row1; r++) {
+            const uint8_t* m = mask + r * f->cell_w;
+            uint16_t* p = (uint16_t*)(fb + ((top + r) * LCD_WIDTH + left) * 2);
+            for (int k = col0; k < col1; k++) {
+                if (m[k]) p[k] = color;
+            }
+        }
+        if (left + col0 < min_x) min_x = left + col0;
+        if (left + col1 > max_x) max_x = left + col1;
+    }
+    if (min_x >= max_x) return;
+
+    // Đánh dấu tile theo hộp bao của cả dòng chữ
+    uint32_t bits = (uint32_t)(((uint64_t)1 << ((max_x - 1) / LCD_TILE_W + 1)) - ((uint64_t)1 << (min_x / LCD_TILE_W)));
+    for (int ty = (top + row0) / LCD_TILE_H; ty <= (top + row1 - 1) / LCD_TILE_H; ty++) o->touched[ty] |= bits;
+}
@@ -0,0 +1,48 @@
+#ifndef LCD_OVERLAY_H
+#define LCD_OVERLAY_H
+
+#include <stdint.h>
+#include "config.h"
+#include "lcd_delta.h"
+
+// Vẽ UI thẳng lên spi_buffer (RGB565 Big Endian) sau khi convert, không sửa frame camera:
+//   - chữ: atlas glyph ASCII dựng sẵn 1 lần bằng cv::putText, vẽ = chép mask -> chi phí theo số pixel chữ
+//   - box: chỉ tô viền
+//   - ghi lại tile đã vẽ (frame này + frame trước) để LCD delta luôn gửi các tile đó
+#define OVERLAY_FIRST_CHAR 32
+#define OVERLAY_LAST_CHAR  126
+#define OVERLAY_GLYPHS     (OVERLAY_LAST_CHAR - OVERLAY_FIRST_CHAR + 1)
+
+typedef struct {
+    uint8_t* mask;          // Ô glyph nối tiếp nhau, mỗi ô cell_w x cell_h (0 / 1)
+    int cell_w, cell_h;
+    int origin_x, origin_y; // Vị trí bút (đầu đường baseline) trong ô
+    int advance[OVERLAY_GLYPHS];
+} OverlayFont;
+
+enum OverlayFontId {
+    OVERLAY_FONT_MESSAGE = 0,   // HERSHEY_SIMPLEX 0.6, dày 2 (message AI)
+    OVERLAY_FONT_STATUS,        // HERSHEY_SIMPLEX 0.5, dày 1 ("Waiting...")
+    OVERLAY_FONT_COUNT
+};
+
+typedef struct {
+    OverlayFont fonts[OVERLAY_FONT_COUNT];
+    uint32_t touched[LCD_TILES_Y];      // Bit tx = tile (tx, ty) bị vẽ ở frame hiện tại
+    uint32_t prev_touched[LCD_TILES_Y]; // ... ở frame trước (phải gửi lại để xóa UI cũ)
+} LcdOverlay;
+
+int  lcd_overlay_init(LcdOverlay* o);
+void lcd_overlay_free(LcdOverlay* o);
+
+// Bắt đầu frame mới (chuyển touched -> prev_touched)
+void lcd_overlay_begin(LcdOverlay* o);
+// Viền chữ nhật dày thickness (giống cv::rectangle: nét nằm giữa cạnh box), color = rgb565_be_pixel
+void lcd_overlay_rect(LcdOverlay* o, uint8_t* fb, int x, int y, int w, int h, uint16_t color, int thickness);
+// Chữ với bút bắt đầu tại (x, baseline) giống cv::putText
+void lcd_overlay_text(LcdOverlay* o, uint8_t* fb, const char* text, int x, int baseline,
+                      OverlayFontId font, uint16_t color);
+// Tile phải gửi: vẽ ở frame này hoặc frame trước (LCD_TILES_Y hàng bitmask)
+void lcd_overlay_dirty(const LcdOverlay* o, uint32_t* rows);
+
+#endif
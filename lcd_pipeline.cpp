@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <string.h>
+#include "lcd_pipeline.h"
+
+int lcd_pipeline_init(LcdPipeline* p) {
+    p->buf[0] = (uint8_t*)malloc(LCD_FRAME_BYTES);
+    p->buf[1] = (uint8_t*)malloc(LCD_FRAME_BYTES);
+    p->ready[0] = p->ready[1] = 0;
+    memset(p->dirty, 0, sizeof(p->dirty));
+    p->fill = 0;
+    p->send = 0;
+    p->running = 1;
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_cond_init(&p->cond, NULL);
+
+    int ok = p->buf[0] && p->buf[1];
+#if LCD_DELTA_UPDATE
+    // lcd_delta_init tự giải phóng khi lỗi; luôn gọi để lcd_delta_free bên dưới an toàn
+    ok = lcd_delta_init(&p->delta) && ok;
+#endif
+    if (!ok) lcd_pipeline_free(p);  // Không để lại buffer/mutex dở dang khi init lỗi giữa chừng
+    return ok;
+}
+
+void lcd_pipeline_free(LcdPipeline* p) {
+    free(p->buf[0]);
+    free(p->buf[1]);
+    p->buf[0] = p->buf[1] = NULL;
+#if LCD_DELTA_UPDATE
+    lcd_delta_free(&p->delta);
+#endif
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->mutex);
+}
+
+uint8_t* lcd_pipeline_acquire(LcdPipeline* p, uint32_t** dirty) {
+    pthread_mutex_lock(&p->mutex);
+    // Chờ nếu buffer này vẫn chưa được gửi đi
+    while (p->running && p->ready[p->fill]) {
+        pthread_cond_wait(&p->cond, &p->mutex);
+    }
+    uint8_t* buf = p->running ? p->buf[p->fill] : NULL;
+    if (dirty) *dirty = p->dirty[p->fill];
+    pthread_mutex_unlock(&p->mutex);
+    return buf;
+}
+
+void lcd_pipeline_submit(LcdPipeline* p) {
+    pthread_mutex_lock(&p->mutex);
+    p->ready[p->fill] = 1;
+    p->fill ^= 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+const uint8_t* lcd_pipeline_next(LcdPipeline* p, const uint32_t** dirty) {
+    pthread_mutex_lock(&p->mutex);
+    while (p->running && !p->ready[p->send]) {
+        pthread_cond_wait(&p->cond, &p->mutex);
+    }
+    const uint8_t* buf = p->running ? p->buf[p->send] : NULL;
+    if (dirty) *dirty = p->dirty[p->send];
+    pthread_mutex_unlock(&p->mutex);
+    return buf;
+}
+
+void lcd_pipeline_release(LcdPipeline* p) {
+    pthread_mutex_lock(&p->mutex);
+    p->ready[p->send] = 0;
+    p->send ^= 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+void lcd_pipeline_stop(LcdPipeline* p) {
+    pthread_mutex_lock(&p->mutex);
+    p->running = 0;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
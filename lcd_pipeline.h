@@ -0,0 +1,47 @@
+#ifndef LCD_PIPELINE_H
+#define LCD_PIPELINE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "config.h"
+#include "lcd_delta.h"
+
+#define LCD_FRAME_BYTES (LCD_WIDTH * LCD_HEIGHT * 2)
+
+// 2 spi_buffer luân phiên (ping-pong) giữa luồng convert và luồng gửi SPI:
+// trong lúc frame N đang truyền, frame N+1 được convert vào buffer còn lại.
+typedef struct {
+    uint8_t* buf[2];
+    uint32_t dirty[2][LCD_TILES_Y]; // Tile overlay đã vẽ của từng buffer (LCD delta luôn gửi)
+    int ready[2];           // 1 = đã convert xong, chờ gửi
+    int fill;               // Buffer converter ghi tiếp theo
+    int send;               // Buffer transmitter gửi tiếp theo
+    int running;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+#if LCD_DELTA_UPDATE
+    LcdDelta delta;         // Chỉ luồng gửi dùng
+#endif
+} LcdPipeline;
+
+int  lcd_pipeline_init(LcdPipeline* p);
+void lcd_pipeline_free(LcdPipeline* p);
+
+// Converter: chờ 1 buffer trống (NULL nếu pipeline đã dừng).
+// dirty (có thể NULL): bitmask tile overlay đi kèm buffer này
+uint8_t* lcd_pipeline_acquire(LcdPipeline* p, uint32_t** dirty);
+// Converter: báo buffer vừa lấy đã convert xong
+void lcd_pipeline_submit(LcdPipeline* p);
+
+// Transmitter: chờ buffer đã convert (NULL nếu pipeline đã dừng)
+const uint8_t* lcd_pipeline_next(LcdPipeline* p, const uint32_t** dirty);
+// Transmitter: trả buffer vừa gửi xong về cho converter
+void lcd_pipeline_release(LcdPipeline* p);
+
+// Đánh thức mọi luồng đang chờ để thoát
+void lcd_pipeline_stop(LcdPipeline* p);
+
+extern LcdPipeline lcd_pipe;
+
+#endif
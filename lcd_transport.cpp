@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include "lcd_transport.h"
+
+// --- BCM2835 ---
+// Mức chân DC đang xuất (-1 = chưa biết): chỉ ghi GPIO khi đổi giữa lệnh và dữ liệu
+static int bcm2835_dc = -1;
+
+static void bcm2835_write(void* ctx, int dc, const uint8_t* buf, uint32_t len) {
+    (void)ctx;
+    if (dc != bcm2835_dc) {
+        bcm2835_gpio_write(PIN_DC, dc);
+        bcm2835_dc = dc;
+    }
+    if (len == 1) {
+        bcm2835_spi_transfer(buf[0]);
+    } else {
+        // writenb chỉ ghi, không đọc ngược MISO -> buffer nguồn giữ nguyên
+        bcm2835_spi_writenb((const char*)buf, len);
+    }
+}
+
+LcdTransport* lcd_transport_bcm2835() {
+    static LcdTransport t = { "bcm2835", bcm2835_write, NULL, 0, 0 };
+    return &t;
+}
+
+// --- SPIDEV ---
+typedef struct {
+    int fd;
+    uint32_t speed_hz;
+    uint32_t chunk;         // Byte tối đa mỗi transfer
+    int dc;                 // Mức chân DC đang xuất (-1 = chưa biết)
+} SpidevCtx;
+
+static SpidevCtx spidev_ctx = { -1, 0, 0, -1 };
+
+// Kernel từ chối message lớn hơn spidev.bufsiz (mặc định 4096, tăng bằng spidev.bufsiz=65536 trong cmdline.txt)
+static uint32_t spidev_bufsiz() {
+    uint32_t n = 4096;
+    FILE* f = fopen("/sys/module/spidev/parameters/bufsiz", "r");
+    if (f) {
+        if (fscanf(f, "%u", &n) != 1 || n == 0) n = 4096;
+        fclose(f);
+    }
+    return n;
+}
+
+static void spidev_write(void* ctx, int dc, const uint8_t* buf, uint32_t len) {
+    SpidevCtx* c = (SpidevCtx*)ctx;
+    // ioctl chỉ trả về khi transfer đã xong -> đổi DC giữa các lần gọi là an toàn
+    if (dc != c->dc) {
+        bcm2835_gpio_write(PIN_DC, dc);
+        c->dc = dc;
+    }
+
+    while (len > 0) {
+        uint32_t n = len < c->chunk ? len : c->chunk;
+        struct spi_ioc_transfer tr;
+        memset(&tr, 0, sizeof(tr));
+        tr.tx_buf = (uintptr_t)buf;
+        tr.len = n;
+        tr.speed_hz = c->speed_hz;
+        tr.bits_per_word = 8;
+        if (ioctl(c->fd, SPI_IOC_MESSAGE(1), &tr) < 0) {
+            printf("[LCD] spidev transfer failed: %s\n", strerror(errno));
+            return;
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+LcdTransport* lcd_transport_spidev(const char* device, uint32_t speed_hz) {
+    static LcdTransport t = { "spidev", spidev_write, &spidev_ctx, 0, 0 };
+    SpidevCtx* c = &spidev_ctx;
+    if (c->fd >= 0) return &t;
+
+    int fd = open(device, O_RDWR);
+    if (fd < 0) {
+        printf("[LCD] Cannot open %s: %s\n", device, strerror(errno));
+        return NULL;
+    }
+    uint8_t mode = SPI_MODE_0;
+    uint8_t bits = 8;
+    if (ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0 || ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0) {
+        printf("[LCD] %s: SPI setup failed: %s\n", device, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    c->fd = fd;
+    c->speed_hz = speed_hz;
+    c->chunk = spidev_bufsiz();
+    if (c->chunk > LCD_SPIDEV_CHUNK) c->chunk = LCD_SPIDEV_CHUNK;
+    printf("[LCD] spidev %s: %.1f MHz, %u B/transfer (%u transfers/frame)\n", device, speed_hz / 1e6,
+           c->chunk, (LCD_WIDTH * LCD_HEIGHT * 2 + c->chunk - 1) / c->chunk);
+    return &t;
+}
+
+// --- MOCK ---
+int lcd_mock_init(LcdMock* m) {
+    memset(m, 0, sizeof(*m));
+    m->fb = (uint8_t*)calloc(LCD_WIDTH * LCD_HEIGHT, 2);
+    m->x2 = LCD_WIDTH - 1;
+    m->y2 = LCD_HEIGHT - 1;
+    m->pending_byte = -1;
+    return m->fb != NULL;
+}
+
+void lcd_mock_free(LcdMock* m) {
+    free(m->fb);
+    m->fb = NULL;
+}
+
+static void mock_pixel(LcdMock* m, uint8_t hi, uint8_t lo) {
+    if (m->cx < LCD_WIDTH && m->cy < LCD_HEIGHT) {
+        uint8_t* p = m->fb + (m->cy * LCD_WIDTH + m->cx) * 2;
+        p[0] = hi;
+        p[1] = lo;
+    }
+    // Hết dòng của cửa sổ -> xuống dòng, hết cửa sổ -> quay lại đầu (giống ILI9341)
+    if (++m->cx > m->x2) {
+        m->cx = m->x1;
+        if (++m->cy > m->y2) m->cy = m->y1;
+    }
+}
+
+static void mock_write(void* ctx, int dc, const uint8_t* buf, uint32_t len) {
+    LcdMock* m = (LcdMock*)ctx;
+    if (len == 0) return;
+    m->writes++;
+
+    if (dc == LOW) {
+        m->cmd_bytes += len;
+        m->cmd = buf[len - 1];
+        m->n_params = 0;
+        m->pending_byte = -1;
+        if (m->cmd == 0x2C) {
+            m->cx = m->x1;
+            m->cy = m->y1;
+        }
+        return;
+    }
+
+    m->data_bytes += len;
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t b = buf[i];
+        if (m->cmd == 0x2C) {
+            if (m->pending_byte < 0) {
+                m->pending_byte = b;
+            } else {
+                mock_pixel(m, (uint8_t)m->pending_byte, b);
+                m->pending_byte = -1;
+            }
+        } else if ((m->cmd == 0x2A || m->cmd == 0x2B) && m->n_params < 4) {
+            m->params[m->n_params++] = b;
+            if (m->n_params == 4) {
+                int a = (m->params[0] << 8) | m->params[1];
+                int z = (m->params[2] << 8) | m->params[3];
+                if (m->cmd == 0x2A) { m->x1 = a; m->x2 = z; }
+                else                { m->y1 = a; m->y2 = z; }
+            }
+        }
+    }
+}
+
+LcdTransport lcd_transport_mock(LcdMock* m) {
+    LcdTransport t = { "mock", mock_write, m, 0, 0 };
+    return t;
+}
+
+int lcd_mock_save_ppm(const LcdMock* m, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+    fprintf(f, "P6\n%d %d\n255\n", LCD_WIDTH, LCD_HEIGHT);
+
+    uint8_t row[LCD_WIDTH * 3];
+    for (int y = 0; y < LCD_HEIGHT; y++) {
+        const uint8_t* p = m->fb + y * LCD_WIDTH * 2;
+        for (int x = 0; x < LCD_WIDTH; x++) {
+            uint16_t c = (p[x * 2] << 8) | p[x * 2 + 1];
+            // Mở rộng 5/6 bit lên 8 bit (lặp bit cao xuống bit thấp)
+            uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            row[x * 3 + 0] = (r << 3) | (r >> 2);
+            row[x * 3 + 1] = (g << 2) | (g >> 4);
+            row[x * 3 + 2] = (b << 3) | (b >> 2);
+        }
+        fwrite(row, 1, sizeof(row), f);
+    }
+    return fclose(f) == 0;
+}
@@ -0,0 +1,58 @@
+#ifndef LCD_TRANSPORT_H
+#define LCD_TRANSPORT_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Lớp vận chuyển byte ra LCD: lcd_driver chỉ gọi qua đây,
+// nên có thể thay phần cứng bcm2835 bằng bản giả lập trong bộ nhớ.
+typedef struct LcdTransport {
+    const char* name;
+    // dc = LOW: byte lệnh, dc = HIGH: byte dữ liệu
+    void (*write)(void* ctx, int dc, const uint8_t* buf, uint32_t len);
+    void* ctx;
+
+    // Thống kê (chỉ luồng gửi LCD ghi, đọc để in MB/s)
+    uint64_t bytes;
+    uint64_t writes;
+} LcdTransport;
+
+static inline void lcd_transport_write(LcdTransport* t, int dc, const uint8_t* buf, uint32_t len) {
+    t->bytes += len;
+    t->writes++;
+    t->write(t->ctx, dc, buf, len);
+}
+
+// Transport mặc định: GPIO + SPI qua thư viện bcm2835 (polling, cần root)
+LcdTransport* lcd_transport_bcm2835();
+
+// --- SPIDEV: SPI qua driver kernel (/dev/spidevB.C, không cần root) ---
+// Frame chia thành vài transfer lớn (SPI_IOC_MESSAGE, tối đa LCD_SPIDEV_CHUNK và spidev.bufsiz)
+// để kernel dùng DMA thay vì giữ 1 core polling. Chân DC vẫn qua bcm2835_gpio_write (/dev/gpiomem).
+// NULL nếu không mở / cấu hình được thiết bị
+LcdTransport* lcd_transport_spidev(const char* device, uint32_t speed_hz);
+
+// --- MOCK: giả lập ILI9341 trong bộ nhớ ---
+// Giải mã lệnh 0x2A / 0x2B / 0x2C và ghi pixel vào framebuffer RGB565 (Big Endian)
+typedef struct {
+    uint8_t* fb;            // LCD_WIDTH * LCD_HEIGHT * 2 byte
+    int x1, x2, y1, y2;     // Cửa sổ hiện tại
+    int cx, cy;             // Vị trí ghi pixel tiếp theo
+    uint8_t cmd;            // Lệnh gần nhất
+    uint8_t params[4];
+    int n_params;
+    int pending_byte;       // Byte cao của pixel đang chờ (-1 = không có)
+
+    // Thống kê
+    uint64_t cmd_bytes;
+    uint64_t data_bytes;
+    uint64_t writes;        // Số lần gọi write (= số giao dịch SPI)
+} LcdMock;
+
+int  lcd_mock_init(LcdMock* m);
+void lcd_mock_free(LcdMock* m);
+LcdTransport lcd_transport_mock(LcdMock* m);
+// Ghi framebuffer ra ảnh PPM (P6) để xem / so sánh nội dung LCD khi chạy replay
+int  lcd_mock_save_ppm(const LcdMock* m, const char* path);
+
+#endif
@@ -1,13 +1,78 @@
 #include <stdio.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
 #include "config.h"
 #include "queue_helper.h"
+#include "frame_pool.h"
+#include "frame_channel.h"
 #include "lcd_driver.h"
+#include "lcd_pipeline.h"
 #include "tasks.h"
+#include "stage_stats.h"
 
 // Định nghĩa thực tế cho các biến extern
 //FrameQueue q_raw;
 FrameQueue q_display;
+FramePool frame_pool;
+FrameChannel ai_channel;
+LcdPipeline lcd_pipe;
+volatile sig_atomic_t app_running = 1;
+volatile sig_atomic_t stats_dump_requested = 0;
+
+static void on_signal(int sig) {
+    app_running = 0;
+}
+
+static void on_stats_signal(int sig) {
+    stats_dump_requested = 1;
+}
+
+// LCD_TRANSPORT=spidev: chọn transport spidev, trả về 1 nếu mở được (build HEADLESS luôn dùng LCD giả lập)
+static int open_spidev() {
+#ifdef HEADLESS
+    return 0;
+#else
+    const char* kind = getenv("LCD_TRANSPORT");
+    if (!kind || !kind[0]) kind = LCD_TRANSPORT_DEFAULT;
+    if (strcmp(kind, "spidev") != 0) return 0;
+
+    const char* dev = getenv("LCD_SPIDEV");
+    const char* hz = getenv("LCD_SPI_HZ");
+    LcdTransport* t = lcd_transport_spidev(dev && dev[0] ? dev : LCD_SPIDEV_DEFAULT,
+                                           hz && hz[0] ? (uint32_t)strtoul(hz, NULL, 10) : LCD_SPI_HZ);
+    if (!t) {
+        printf("spidev unavailable, falling back to bcm2835 SPI\n");
+        return 0;
+    }
+    lcd_set_transport(t);
+    return 1;
+#endif
+}
+
+#ifdef HEADLESS
+// Build replay: LCD giả lập trong RAM thay cho ILI9341 qua SPI
+static LcdMock lcd_mock;
+static LcdTransport mock_transport;
+
+static void headless_report() {
+    Bcm2835StubStats st = bcm2835_stub_stats();
+    printf("[Headless] LCD mock: %llu writes | cmd %llu B | data %llu B\n",
+           (unsigned long long)lcd_mock.writes, (unsigned long long)lcd_mock.cmd_bytes,
+           (unsigned long long)lcd_mock.data_bytes);
+    printf("[Headless] bcm2835 stub: gpio %llu | spi %llu calls, %llu B | delay %llu ms\n",
+           (unsigned long long)st.gpio_writes, (unsigned long long)st.spi_calls,
+           (unsigned long long)st.spi_bytes, (unsigned long long)st.delay_ms);
+
+    // REPLAY_LCD_OUT=last.ppm: lưu nội dung màn hình cuối cùng
+    const char* out = getenv("REPLAY_LCD_OUT");
+    if (out && out[0]) {
+        if (lcd_mock_save_ppm(&lcd_mock, out)) printf("[Headless] LCD saved to %s\n", out);
+        else printf("[Headless] Cannot write %s\n", out);
+    }
+}
+#endif
 
 int main() {
     // 1. Init Hardware
@@ -18,35 +83,74 @@ int main() {
     bcm2835_gpio_fsel(PIN_DC, BCM2835_GPIO_FSEL_OUTP);
     bcm2835_gpio_fsel(PIN_RST, BCM2835_GPIO_FSEL_OUTP);
     
-    // Cấu hình SPI
-    bcm2835_spi_begin();
-    bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
-    bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
-    bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_8);
-    bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
-    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
+    // Cấu hình SPI: LCD_TRANSPORT=spidev dùng driver kernel (DMA), không được thì quay về bcm2835
+    int bcm_spi = !open_spidev();
+    if (bcm_spi) {
+        bcm2835_spi_begin();
+        bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
+        bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
+        bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_8);
+        bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
+        bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
+    }
     
     printf("System initializing...\n");
+#ifdef HEADLESS
+    if (!lcd_mock_init(&lcd_mock)) {
+        printf("LCD mock malloc failed!\n");
+        return 1;
+    }
+    mock_transport = lcd_transport_mock(&lcd_mock);
+    lcd_set_transport(&mock_transport);
+#endif
     lcd_init_full();
     
     // 2. Init Queues
 //    queue_init(&q_raw);
+    frame_pool_init(&frame_pool);
     queue_init(&q_display);
+    frame_channel_init(&ai_channel);
+    if (!lcd_pipeline_init(&lcd_pipe)) {
+        printf("LCD pipeline malloc failed!\n");
+        return 1;
+    }
+
+    // Ctrl+C: dừng êm (Camera đóng queue/channel, các luồng còn lại tự thoát)
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    // kill -USR1 <pid>: in thống kê từng stage (p50/p95/p99, FPS)
+    signal(SIGUSR1, on_stats_signal);
+    stage_stats_init();
 
     // 3. Create Tasks
-    pthread_t t_cam, t_ai, t_lcd;
+    pthread_t t_cam, t_ai, t_lcd, t_lcd_tx, t_stats;
     printf("Starting tasks...\n");
     
     pthread_create(&t_cam, NULL, task_camera, NULL);
     pthread_create(&t_ai,  NULL, task_ai_improved, NULL);
     pthread_create(&t_lcd, NULL, task_lcd,    NULL);
+    pthread_create(&t_lcd_tx, NULL, task_lcd_tx, NULL);
+    pthread_create(&t_stats, NULL, task_stats, NULL);
     
     // 4. Loop
     pthread_join(t_cam, NULL);
     pthread_join(t_ai,  NULL);
     pthread_join(t_lcd, NULL);
+    pthread_join(t_lcd_tx, NULL);
+    pthread_join(t_stats, NULL);
+
+    // Thống kê cả phần cuối (từ lần dump gần nhất tới khi dừng)
+    stage_stats_dump(stdout);
+
+    lcd_pipeline_free(&lcd_pipe);
+    frame_channel_free(&ai_channel);
+    printf("System stopped\n");
+#ifdef HEADLESS
+    headless_report();
+    lcd_mock_free(&lcd_mock);
+#endif
 
-    bcm2835_spi_end();
+    if (bcm_spi) bcm2835_spi_end();
     bcm2835_close();
     return 0;
 }
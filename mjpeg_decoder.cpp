@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mjpeg_decoder.h"
+
+static void on_error(j_common_ptr cinfo) {
+    MjpegError* err = (MjpegError*)cinfo->err;
+    longjmp(err->jump, 1);
+}
+
+// Frame camera hay có cảnh báo nhỏ (thiếu byte cuối...), không in ra mỗi frame
+static void on_message(j_common_ptr cinfo) {
+}
+
+int mjpeg_decoder_init(MjpegDecoder* d) {
+    memset(d, 0, sizeof(*d));
+    d->cinfo.err = jpeg_std_error(&d->err.mgr);
+    d->err.mgr.error_exit = on_error;
+    d->err.mgr.output_message = on_message;
+    if (setjmp(d->err.jump)) return 0;
+    jpeg_create_decompress(&d->cinfo);
+    d->scale_denom = 1;
+    return 1;
+}
+
+void mjpeg_decoder_free(MjpegDecoder* d) {
+    jpeg_destroy_decompress(&d->cinfo);
+    free(d->scratch);
+    d->scratch = NULL;
+    d->scratch_size = 0;
+}
+
+// Tỉ lệ IDCT nhỏ nhất mà ảnh ra vẫn không nhỏ hơn đích (ceil giống jpeg_calc_output_dimensions)
+static int pick_scale(int src_w, int src_h, int width, int height) {
+    for (int denom = 8; denom > 1; denom /= 2) {
+        if ((src_w + denom - 1) / denom >= width && (src_h + denom - 1) / denom >= height) return denom;
+    }
+    return 1;
+}
+
+int mjpeg_decode(MjpegDecoder* d, const uint8_t* data, size_t size,
+                 uint8_t* dst, int width, int height, size_t stride) {
+    struct jpeg_decompress_struct* cinfo = &d->cinfo;
+    if (setjmp(d->err.jump)) {
+        jpeg_abort_decompress(cinfo);
+        d->errors++;
+        return MJPEG_DECODE_FAILED;
+    }
+
+    // Webcam MJPEG thường bỏ bảng Huffman (DHT): libjpeg-turbo tự dùng bảng chuẩn
+    jpeg_mem_src(cinfo, (unsigned char*)data, (unsigned long)size);
+    jpeg_read_header(cinfo, TRUE);
+
+    d->scale_denom = pick_scale(cinfo->image_width, cinfo->image_height, width, height);
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = d->scale_denom;
+#ifdef JCS_EXTENSIONS
+    cinfo->out_color_space = JCS_EXT_BGR;   // libjpeg-turbo ghi thẳng BGR như OpenCV
+#else
+    cinfo->out_color_space = JCS_RGB;
+#endif
+    cinfo->dct_method = JDCT_IFAST;
+    cinfo->do_fancy_upsampling = FALSE;     // Chroma 4:2:2 nhân đôi thay vì nội suy: nhanh hơn, ảnh 320x240 khó thấy khác
+    jpeg_calc_output_dimensions(cinfo);
+    d->out_w = cinfo->output_width;
+    d->out_h = cinfo->output_height;
+
+    uint8_t* out = dst;
+    size_t out_stride = stride;
+    int direct = d->out_w == width && d->out_h == height;
+    if (!direct) {
+        size_t need = (size_t)d->out_w * d->out_h * 3;
+        if (need > d->scratch_size) {
+            uint8_t* p = (uint8_t*)realloc(d->scratch, need);
+            if (!p) {
+                jpeg_abort_decompress(cinfo);
+                d->errors++;
+                return MJPEG_DECODE_FAILED;
+            }
+            d->scratch = p;
+            d->scratch_size = need;
+        }
+        out = d->scratch;
+        out_stride = (size_t)d->out_w * 3;
+    }
+
+    jpeg_start_decompress(cinfo);
+    while (cinfo->output_scanline < cinfo->output_height) {
+        JSAMPROW rows[4];
+        int n = 0;
+        for (; n < 4 && cinfo->output_scanline + n < cinfo->output_height; n++) {
+            rows[n] = out + (cinfo->output_scanline + n) * out_stride;
+        }
+        jpeg_read_scanlines(cinfo, rows, n);
+    }
+    jpeg_finish_decompress(cinfo);
+
+#ifndef JCS_EXTENSIONS
+    // libjpeg gốc không có BGR: đảo R, B tại chỗ
+    for (int y = 0; y < d->out_h; y++) {
+        uint8_t* p = out + y * out_stride;
+        for (int x = 0; x < d->out_w; x++, p += 3) {
+            uint8_t t = p[0];
+            p[0] = p[2];
+            p[2] = t;
+        }
+    }
+#endif
+    return direct ? MJPEG_DECODE_DIRECT : MJPEG_DECODE_SCRATCH;
+}
@@ -0,0 +1,41 @@
+#ifndef MJPEG_DECODER_H
+#define MJPEG_DECODER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+
+// Giải nén frame MJPEG bằng libjpeg(-turbo) với IDCT thu nhỏ (1/2, 1/4, 1/8): chọn tỉ lệ nhỏ nhất
+// vẫn >= kích thước đích nên phần lớn hệ số DCT không phải biến đổi, không cần resize nếu khớp đúng.
+// Dùng lại 1 decoder cho mọi frame (không cấp phát lại mỗi frame).
+typedef struct {
+    struct jpeg_error_mgr mgr;
+    jmp_buf jump;                   // Lỗi libjpeg -> longjmp về mjpeg_decode thay vì exit()
+} MjpegError;
+
+typedef struct {
+    struct jpeg_decompress_struct cinfo;
+    MjpegError err;
+    uint8_t* scratch;               // BGR khi ảnh sau IDCT không khớp đúng kích thước đích
+    size_t scratch_size;
+    int out_w, out_h;               // Kích thước sau IDCT của frame gần nhất
+    int scale_denom;                // 1, 2, 4, 8
+    uint64_t errors;                // Số frame hỏng đã bỏ qua
+} MjpegDecoder;
+
+enum {
+    MJPEG_DECODE_FAILED = 0,
+    MJPEG_DECODE_DIRECT,            // Đã ghi thẳng vào dst
+    MJPEG_DECODE_SCRATCH,           // BGR out_w x out_h trong scratch (stride out_w * 3), caller tự resize
+};
+
+int  mjpeg_decoder_init(MjpegDecoder* d);
+void mjpeg_decoder_free(MjpegDecoder* d);
+
+// Giải nén 1 ảnh JPEG thành BGR width x height vào dst (stride byte mỗi dòng)
+int  mjpeg_decode(MjpegDecoder* d, const uint8_t* data, size_t size,
+                  uint8_t* dst, int width, int height, size_t stride);
+
+#endif
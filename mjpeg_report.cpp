@@ -0,0 +1,125 @@
+// So sánh giải nén MJPEG trên 1 stream đã ghi (các ảnh JPEG nối tiếp, ffmpeg -f mjpeg):
+//   opencv : cv::VideoCapture đọc file (decode full resolution) + cv::resize như task_camera cũ
+//   imdecode: cv::imdecode từng ảnh + cv::resize (giống backend V4L2 của OpenCV với camera MJPEG)
+//   scaled : mjpeg_decode với IDCT thu nhỏ thẳng ra LCD_WIDTH x LCD_HEIGHT (CAMERA_BACKEND=mjpeg)
+//   make mjpeg_report
+//   ./mjpeg_report clip.mjpeg
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "config.h"
+#include "v4l2_capture.h"
+#include "mjpeg_decoder.h"
+#include "frame_pool.h"
+
+#define REPORT_PASSES 3     // Đọc cả stream N lần, lấy mọi mẫu
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+static void printRun(const char* name, const std::vector<double>& ms) {
+    double sum = 0.0;
+    for (double v : ms) sum += v;
+    double avg = ms.empty() ? 0.0 : sum / ms.size();
+    printf("%-9s frames %5zu | avg %6.2f ms | p50 %6.2f | p95 %6.2f | %6.1f fps\n",
+           name, ms.size(), avg, percentile(ms, 0.50), percentile(ms, 0.95), avg > 0.0 ? 1000.0 / avg : 0.0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <stream.mjpeg>\n", argv[0]);
+        return 1;
+    }
+
+    V4l2Capture src;
+    if (!v4l2_capture_open(&src, argv[1], MJPEG_CAPTURE_W, MJPEG_CAPTURE_H, CAMERA_FPS, V4L2_PIX_FMT_MJPEG)) {
+        return 1;
+    }
+    std::vector<cv::Mat> jpegs;
+    const uint8_t* data;
+    size_t size;
+    while (v4l2_capture_next(&src, &data, &size, 0) == 1) {
+        jpegs.push_back(cv::Mat(1, (int)size, CV_8UC1, (void*)data));
+    }
+
+    // Thiết bị thật (/dev/videoN) hoặc file không có ảnh JPEG trọn vẹn nào
+    if (jpegs.empty()) {
+        printf("No complete JPEG frame in %s (expected a recorded MJPEG stream file)\n", argv[1]);
+        v4l2_capture_close(&src);
+        return 1;
+    }
+
+    cv::Mat first = cv::imdecode(jpegs[0], cv::IMREAD_COLOR);
+    printf("Stream: %zu frames %dx%d -> %dx%d | %d passes\n\n", jpegs.size(), first.cols, first.rows,
+           LCD_WIDTH, LCD_HEIGHT, REPORT_PASSES);
+
+    cv::Mat out(LCD_HEIGHT, LCD_WIDTH, CV_8UC3);
+    cv::Mat full;
+    std::vector<double> ms_opencv, ms_imdecode, ms_scaled;
+
+    // 1. Đường cũ: VideoCapture + resize
+    for (int pass = 0; pass < REPORT_PASSES; pass++) {
+        cv::VideoCapture cap(argv[1]);
+        if (!cap.isOpened()) {
+            printf("VideoCapture cannot open %s (skipped)\n", argv[1]);
+            break;
+        }
+        while (1) {
+            uint64_t t0 = frame_clock_ns();
+            cap >> full;
+            if (full.empty()) break;
+            cv::resize(full, out, cv::Size(LCD_WIDTH, LCD_HEIGHT));
+            ms_opencv.push_back((frame_clock_ns() - t0) / 1e6);
+        }
+    }
+
+    // 2. imdecode full resolution + resize
+    for (int pass = 0; pass < REPORT_PASSES; pass++) {
+        for (size_t i = 0; i < jpegs.size(); i++) {
+            uint64_t t0 = frame_clock_ns();
+            cv::imdecode(jpegs[i], cv::IMREAD_COLOR, &full);
+            cv::resize(full, out, cv::Size(LCD_WIDTH, LCD_HEIGHT));
+            ms_imdecode.push_back((frame_clock_ns() - t0) / 1e6);
+        }
+    }
+
+    // 3. IDCT thu nhỏ thẳng vào buffer đích (+ resize nếu tỉ lệ không khớp)
+    MjpegDecoder dec;
+    mjpeg_decoder_init(&dec);
+    cv::Mat ref;
+    double diff_sum = 0.0;
+    for (int pass = 0; pass < REPORT_PASSES; pass++) {
+        for (size_t i = 0; i < jpegs.size(); i++) {
+            uint64_t t0 = frame_clock_ns();
+            int r = mjpeg_decode(&dec, jpegs[i].data, jpegs[i].total(), out.data, out.cols, out.rows, out.step);
+            if (r == MJPEG_DECODE_SCRATCH) {
+                cv::resize(cv::Mat(dec.out_h, dec.out_w, CV_8UC3, dec.scratch), out,
+                           cv::Size(LCD_WIDTH, LCD_HEIGHT), 0, 0, cv::INTER_AREA);
+            }
+            ms_scaled.push_back((frame_clock_ns() - t0) / 1e6);
+
+            // Sai khác trung bình mỗi kênh so với imdecode + resize INTER_AREA (chỉ lượt đầu)
+            if (pass == 0 && r != MJPEG_DECODE_FAILED) {
+                cv::resize(cv::imdecode(jpegs[i], cv::IMREAD_COLOR), ref,
+                           cv::Size(LCD_WIDTH, LCD_HEIGHT), 0, 0, cv::INTER_AREA);
+                diff_sum += cv::norm(out, ref, cv::NORM_L1) / out.total() / 3;
+            }
+        }
+    }
+
+    printRun("opencv", ms_opencv);
+    printRun("imdecode", ms_imdecode);
+    printRun("scaled", ms_scaled);
+    printf("\nScaled IDCT 1/%d | corrupt frames %llu | mean |diff| vs full decode %.2f levels\n",
+           dec.scale_denom, (unsigned long long)dec.errors / REPORT_PASSES,
+           diff_sum / jpegs.size());
+
+    mjpeg_decoder_free(&dec);
+    v4l2_capture_close(&src);
+    return 0;
+}
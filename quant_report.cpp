@@ -0,0 +1,121 @@
+// So sánh model FP32 và INT8 (QDQ) trên tập ảnh khuôn mặt đã crop:
+// latency mỗi lần forward và độ lệch cosine similarity so với FP32.
+//   make quant_report
+//   ./quant_report <thư mục ảnh> [model_fp32.onnx] [model_int8.onnx]
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include "config.h"
+#include "facenet.h"
+
+#define REPORT_REPEAT 5     // Số lần forward mỗi ảnh để đo latency
+#define REPORT_WARMUP 3
+
+struct ModelRun {
+    const char* path;
+    FaceNet net;
+    std::vector<cv::Mat> embs;
+    std::vector<double> ms;     // Latency từng lần forward
+};
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+static bool runModel(ModelRun& run, const std::vector<cv::Mat>& faces) {
+    run.net.loadModel(run.path);
+    if (!run.net.isLoaded()) return false;
+
+    for (int i = 0; i < REPORT_WARMUP && !faces.empty(); i++) run.net.getEmbedding(faces[0]);
+
+    for (size_t i = 0; i < faces.size(); i++) {
+        cv::Mat emb;
+        for (int r = 0; r < REPORT_REPEAT; r++) {
+            int64 t0 = cv::getTickCount();
+            emb = run.net.getEmbedding(faces[i]);
+            run.ms.push_back((cv::getTickCount() - t0) * 1000.0 / cv::getTickFrequency());
+        }
+        run.embs.push_back(emb.reshape(1, 1).clone());
+    }
+    return true;
+}
+
+static void printLatency(const ModelRun& run) {
+    double sum = 0.0;
+    for (double v : run.ms) sum += v;
+    printf("%-28s dim %4d | forward avg %7.2f ms | p50 %7.2f | p95 %7.2f\n",
+           run.path, run.net.getEmbeddingDim(), sum / run.ms.size(),
+           percentile(run.ms, 0.50), percentile(run.ms, 0.95));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <face_dir> [fp32.onnx] [int8.onnx]\n", argv[0]);
+        return 1;
+    }
+    std::string dir = argv[1];
+
+    ModelRun fp32, int8;
+    fp32.path = argc > 2 ? argv[2] : FACENET_MODEL_PATH;
+    int8.path = argc > 3 ? argv[3] : FACENET_MODEL_INT8_PATH;
+
+    // Ảnh khuôn mặt đã crop (jpg/png), kích thước bất kỳ
+    std::vector<cv::String> files, more;
+    cv::glob(dir + "/*.jpg", files, false);
+    cv::glob(dir + "/*.png", more, false);
+    files.insert(files.end(), more.begin(), more.end());
+
+    std::vector<cv::Mat> faces;
+    for (size_t i = 0; i < files.size(); i++) {
+        cv::Mat img = cv::imread(files[i], cv::IMREAD_COLOR);
+        if (!img.empty()) faces.push_back(img);
+    }
+    if (faces.empty()) {
+        printf("No images in %s\n", dir.c_str());
+        return 1;
+    }
+    printf("Faces: %zu | repeat %d\n\n", faces.size(), REPORT_REPEAT);
+
+    if (!runModel(fp32, faces) || !runModel(int8, faces)) {
+        printf("Cannot load models\n");
+        return 1;
+    }
+    printLatency(fp32);
+    printLatency(int8);
+    if (fp32.net.getEmbeddingDim() != int8.net.getEmbeddingDim()) {
+        printf("\nEmbedding dim mismatch -> INT8 model is not usable with the FP32 gallery\n");
+        return 1;
+    }
+
+    // 1. Cùng ảnh: cosine(FP32, INT8), càng gần 1 càng tốt
+    double self_sum = 0.0, self_min = 1.0;
+    for (size_t i = 0; i < faces.size(); i++) {
+        double c = fp32.embs[i].dot(int8.embs[i]);
+        self_sum += c;
+        self_min = std::min(self_min, c);
+    }
+
+    // 2. Từng cặp ảnh: |cos_int8(i,j) - cos_fp32(i,j)| -> ảnh hưởng trực tiếp tới ngưỡng nhận diện
+    double drift_sum = 0.0, drift_max = 0.0;
+    size_t pairs = 0;
+    for (size_t i = 0; i < faces.size(); i++) {
+        for (size_t j = i + 1; j < faces.size(); j++) {
+            double d = fabs(int8.embs[i].dot(int8.embs[j]) - fp32.embs[i].dot(fp32.embs[j]));
+            drift_sum += d;
+            drift_max = std::max(drift_max, d);
+            pairs++;
+        }
+    }
+
+    printf("\nSame face  cos(fp32, int8): avg %.4f | min %.4f\n", self_sum / faces.size(), self_min);
+    if (pairs > 0) {
+        printf("Pair drift |dcos|          : avg %.4f | max %.4f (%zu pairs)\n",
+               drift_sum / pairs, drift_max, pairs);
+    }
+    return 0;
+}
@@ -1,34 +1,107 @@
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <limits.h>
 #include "queue_helper.h"
 
+#define SLOT_MASK (QUEUE_SLOTS - 1)
+
+static_assert((QUEUE_SLOTS & SLOT_MASK) == 0, "QUEUE_SLOTS phai la luy thua cua 2");
+static_assert(QUEUE_SLOTS > QUEUE_SIZE, "Can it nhat 1 slot du cho consumer dang doc");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex can word 32-bit");
+
+static void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t>* addr) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
 void queue_init(FrameQueue* q) {
-    q->head = 0; q->tail = 0; q->count = 0;
-    pthread_mutex_init(&q->mutex, NULL);
-    pthread_cond_init(&q->cond_not_empty, NULL);
+    for (int i = 0; i < QUEUE_SLOTS; i++) {
+        q->frames[i].reset();
+    }
+    q->head = 0;
+    q->tail = 0;
+    q->reading = 0;
+    q->waiting = 0;
+    q->closed = 0;
+    q->pushed = 0;
+    q->dropped = 0;
 }
 
-void queue_push(FrameQueue* q, cv::Mat frame) {
-    pthread_mutex_lock(&q->mutex);
-    if (q->count == QUEUE_SIZE) {
-//	printf("Warning: Queue full, dropping oldest frame!\n");
-        q->head = (q->tail + 1) % QUEUE_SIZE;
-        q->count--;
+void queue_push(FrameQueue* q, const FrameHandle& frame) {
+    uint32_t t = q->tail.load(std::memory_order_relaxed);
+    uint32_t h = q->head.load();
+
+    // Đầy -> bỏ frame cũ nhất. CAS có thể thua consumer vừa lấy đúng slot đó, khi đó h được cập nhật
+    while (t - h >= QUEUE_SIZE) {
+        if (q->head.compare_exchange_weak(h, h + 1)) {
+//	    printf("Warning: Queue full, dropping oldest frame!\n");
+            // Thắng CAS -> consumer không thể lấy slot này nữa, trả buffer về pool ngay
+            q->frames[h & SLOT_MASK].reset();
+            q->dropped++;
+            h++;
+        }
+    }
+
+    // Consumer vẫn đang lấy ra đúng slot sắp ghi (chỉ xảy ra khi consumer bị treo
+    // trong lúc producer đã vòng qua cả ring) -> bỏ frame mới thay vì ghi đè
+    if (q->reading.load() == (t & SLOT_MASK) + 1) {
+        q->dropped++;
+        return;
+    }
+
+    q->frames[t & SLOT_MASK] = frame;
+    q->pushed++;
+    q->tail.store(t + 1);
+
+    if (q->waiting.load()) {
+        futex_wake(&q->tail);
     }
-    q->frames[q->tail] = frame;
-    q->tail = (q->tail + 1) % QUEUE_SIZE;
-    q->count++;
-    pthread_cond_signal(&q->cond_not_empty);
-    pthread_mutex_unlock(&q->mutex);
-}
-
-void queue_pop(FrameQueue* q, cv::Mat* frame_out) {
-    pthread_mutex_lock(&q->mutex);
-    //ch? n?u queue r?ng
-    while (q->count == 0) {
-        pthread_cond_wait(&q->cond_not_empty, &q->mutex);
+}
+
+int queue_pop(FrameQueue* q, FrameHandle* frame_out) {
+    uint32_t h;
+    while (1) {
+        h = q->head.load();
+        uint32_t t = q->tail.load();
+
+        // Rỗng -> ngủ tới khi producer đổi tail
+        if (h == t) {
+            if (q->closed.load()) return 0;
+            q->waiting.store(1);
+            if (q->tail.load() == t) {
+                futex_wait(&q->tail, t);
+            }
+            q->waiting.store(0);
+            continue;
+        }
+
+        // Báo slot sắp đọc TRƯỚC khi nhận slot, để producer không ghi đè khi vòng lại
+        q->reading.store((h & SLOT_MASK) + 1);
+        if (q->head.compare_exchange_strong(h, h + 1)) break;
+        // Producer vừa drop đúng slot này -> thử lại
+        q->reading.store(0);
     }
-    *frame_out = q->frames[q->head];
-    //C?p nh?t head
-    q->head = (q->head + 1) % QUEUE_SIZE;
-    q->count--;
-    pthread_mutex_unlock(&q->mutex);
+
+    *frame_out = std::move(q->frames[h & SLOT_MASK]);
+    q->reading.store(0);
+    // Handle rỗng = dấu kết thúc do queue_close đẩy vào
+    return !frame_out->empty();
+}
+
+void queue_close(FrameQueue* q) {
+    // Đặt cờ trước rồi đẩy 1 handle rỗng để tail đổi -> consumer đang ngủ chắc chắn thức dậy
+    q->closed.store(1);
+    queue_push(q, FrameHandle());
+}
+
+uint64_t queue_pushed(FrameQueue* q) {
+    return q->pushed.load(std::memory_order_relaxed);
+}
+
+uint64_t queue_dropped(FrameQueue* q) {
+    return q->dropped.load(std::memory_order_relaxed);
 }
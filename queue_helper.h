@@ -2,23 +2,37 @@
 #define QUEUE_HELPER_H
 
 #include <opencv4/opencv2/opencv.hpp>
-#include <pthread.h>
+#include <atomic>
+#include <stdint.h>
 #include "config.h"
+#include "frame_pool.h"
 
-
+// Hàng đợi vòng lock-free 1 producer / 1 consumer (SPSC).
+// - Slot giữ FrameHandle của pool, push/pop chỉ tăng/chuyển tham chiếu -> không copy, không malloc
+// - Đầy thì bỏ frame cũ nhất (như bản mutex trước đây) và đếm số frame bị bỏ
+// - Consumer ngủ bằng futex trên tail, không spin
 typedef struct {
-    cv::Mat frames[QUEUE_SIZE];
-    int head;
-    int tail;
-    int count;
-    pthread_mutex_t mutex;
-    pthread_cond_t cond_not_empty;
+    FrameHandle frames[QUEUE_SLOTS];
+    std::atomic<uint32_t> head;     // Vị trí đọc tiếp theo (consumer lấy, producer đẩy lên khi drop)
+    std::atomic<uint32_t> tail;     // Vị trí ghi tiếp theo (chỉ producer) - cũng là futex word
+    std::atomic<uint32_t> reading;  // Slot consumer đang lấy ra (+1), 0 = không đọc
+    std::atomic<uint32_t> waiting;  // Consumer đang ngủ trên futex
+    std::atomic<uint32_t> closed;   // Producer đã dừng
+    std::atomic<uint64_t> pushed;
+    std::atomic<uint64_t> dropped;
 } FrameQueue;
 
 // Khai báo hàm
 void queue_init(FrameQueue* q);
-void queue_push(FrameQueue* q, cv::Mat frame);
-void queue_pop(FrameQueue* q, cv::Mat* frame_out);
+void queue_push(FrameQueue* q, const FrameHandle& frame);
+// Trả về 1 nếu lấy được frame, 0 nếu queue đã đóng và hết frame
+int  queue_pop(FrameQueue* q, FrameHandle* frame_out);
+// Producer: báo hết frame (đánh thức consumer đang ngủ)
+void queue_close(FrameQueue* q);
+
+// Thống kê
+uint64_t queue_pushed(FrameQueue* q);
+uint64_t queue_dropped(FrameQueue* q);
 
 // Khai báo biến toàn cục (extern) để các file khác cùng thấy
 //extern FrameQueue q_raw;
@@ -0,0 +1,245 @@
+#include "rgb565.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RGB565_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define RGB565_NEON 1
+#if defined(__arm__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+// --- BẢN SCALAR (THAM CHIẾU) ---
+void bgr_to_rgb565_scalar(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++) {
+        uint8_t b = src[0];
+        uint8_t g = src[1];
+        uint8_t r = src[2];
+
+        uint16_t c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+
+        // Big Endian cho SPI
+        dst[0] = (c >> 8) & 0xFF;
+        dst[1] = c & 0xFF;
+        src += 3;
+        dst += 2;
+    }
+}
+
+#ifdef RGB565_X86
+// Bảng pshufb tách 16 pixel BGR (48 byte = 3 thanh ghi a,b,c) thành 3 kênh.
+// Giá trị -1 = ghi 0 vào byte đó.
+alignas(16) static const int8_t SHUF_B[3][16] = {
+    { 0, 3, 6, 9,12,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+    {-1,-1,-1,-1,-1,-1, 2, 5, 8,11,14,-1,-1,-1,-1,-1},
+    {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 1, 4, 7,10,13},
+};
+alignas(16) static const int8_t SHUF_G[3][16] = {
+    { 1, 4, 7,10,13,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+    {-1,-1,-1,-1,-1, 0, 3, 6, 9,12,15,-1,-1,-1,-1,-1},
+    {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 2, 5, 8,11,14},
+};
+alignas(16) static const int8_t SHUF_R[3][16] = {
+    { 2, 5, 8,11,14,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+    {-1,-1,-1,-1,-1, 1, 4, 7,10,13,-1,-1,-1,-1,-1,-1},
+    {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 0, 3, 6, 9,12,15},
+};
+
+__attribute__((target("ssse3")))
+static void bgr_to_rgb565_ssse3(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    const __m128i* mb = (const __m128i*)SHUF_B;
+    const __m128i* mg = (const __m128i*)SHUF_G;
+    const __m128i* mr = (const __m128i*)SHUF_R;
+    const __m128i m_f8 = _mm_set1_epi8((char)0xF8);
+    const __m128i m_1c = _mm_set1_epi8(0x1C);
+    const __m128i m_1f = _mm_set1_epi8(0x1F);
+    const __m128i m_07 = _mm_set1_epi8(0x07);
+
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+
+        __m128i vb = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, mb[0]), _mm_shuffle_epi8(b, mb[1])),
+                                  _mm_shuffle_epi8(c, mb[2]));
+        __m128i vg = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, mg[0]), _mm_shuffle_epi8(b, mg[1])),
+                                  _mm_shuffle_epi8(c, mg[2]));
+        __m128i vr = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, mr[0]), _mm_shuffle_epi8(b, mr[1])),
+                                  _mm_shuffle_epi8(c, mr[2]));
+
+        // hi = RRRRRGGG, lo = GGGBBBBB (không có shift 8-bit nên shift 16-bit rồi mask)
+        __m128i hi = _mm_or_si128(_mm_and_si128(vr, m_f8),
+                                  _mm_and_si128(_mm_srli_epi16(vg, 5), m_07));
+        __m128i lo = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(vg, m_1c), 3),
+                                  _mm_and_si128(_mm_srli_epi16(vb, 3), m_1f));
+
+        _mm_storeu_si128((__m128i*)(dst + 0),  _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi8(hi, lo));
+        src += 48;
+        dst += 32;
+    }
+    bgr_to_rgb565_scalar(src, dst, pixels - i);
+}
+
+__attribute__((target("avx2")))
+static void bgr_to_rgb565_avx2(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    // Mỗi lane 128-bit xử lý 16 pixel riêng -> dùng lại bảng pshufb của SSSE3
+    const __m256i mb0 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_B[0]));
+    const __m256i mb1 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_B[1]));
+    const __m256i mb2 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_B[2]));
+    const __m256i mg0 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_G[0]));
+    const __m256i mg1 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_G[1]));
+    const __m256i mg2 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_G[2]));
+    const __m256i mr0 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_R[0]));
+    const __m256i mr1 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_R[1]));
+    const __m256i mr2 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)SHUF_R[2]));
+    const __m256i m_f8 = _mm256_set1_epi8((char)0xF8);
+    const __m256i m_1c = _mm256_set1_epi8(0x1C);
+    const __m256i m_1f = _mm256_set1_epi8(0x1F);
+    const __m256i m_07 = _mm256_set1_epi8(0x07);
+
+    size_t i = 0;
+    for (; i + 32 <= pixels; i += 32) {
+        // Lane 0 = pixel 0..15, lane 1 = pixel 16..31
+        __m256i a = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(src + 0))),
+            _mm_loadu_si128((const __m128i*)(src + 48)), 1);
+        __m256i b = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(src + 16))),
+            _mm_loadu_si128((const __m128i*)(src + 64)), 1);
+        __m256i c = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(src + 32))),
+            _mm_loadu_si128((const __m128i*)(src + 80)), 1);
+
+        __m256i vb = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, mb0), _mm256_shuffle_epi8(b, mb1)),
+                                     _mm256_shuffle_epi8(c, mb2));
+        __m256i vg = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, mg0), _mm256_shuffle_epi8(b, mg1)),
+                                     _mm256_shuffle_epi8(c, mg2));
+        __m256i vr = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, mr0), _mm256_shuffle_epi8(b, mr1)),
+                                     _mm256_shuffle_epi8(c, mr2));
+
+        __m256i hi = _mm256_or_si256(_mm256_and_si256(vr, m_f8),
+                                     _mm256_and_si256(_mm256_srli_epi16(vg, 5), m_07));
+        __m256i lo = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(vg, m_1c), 3),
+                                     _mm256_and_si256(_mm256_srli_epi16(vb, 3), m_1f));
+
+        __m256i p_lo = _mm256_unpacklo_epi8(hi, lo);  // pixel 0..7  | 16..23
+        __m256i p_hi = _mm256_unpackhi_epi8(hi, lo);  // pixel 8..15 | 24..31
+        _mm256_storeu_si256((__m256i*)(dst + 0),  _mm256_permute2x128_si256(p_lo, p_hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(dst + 32), _mm256_permute2x128_si256(p_lo, p_hi, 0x31));
+        src += 96;
+        dst += 64;
+    }
+    bgr_to_rgb565_scalar(src, dst, pixels - i);
+}
+#endif
+
+#ifdef RGB565_NEON
+static void bgr_to_rgb565_neon(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x3_t bgr = vld3q_u8(src);   // tách kênh sẵn
+        uint8x16x2_t out;
+        // hi = RRRRRGGG: giữ 5 bit cao của R, chèn G >> 5
+        out.val[0] = vsriq_n_u8(bgr.val[2], bgr.val[1], 5);
+        // lo = GGGBBBBB: (G << 3) giữ 3 bit cao, chèn B >> 3
+        out.val[1] = vsriq_n_u8(vshlq_n_u8(bgr.val[1], 3), bgr.val[0], 3);
+        vst2q_u8(dst, out);                 // xen kẽ hi/lo = Big Endian
+        src += 48;
+        dst += 32;
+    }
+    bgr_to_rgb565_scalar(src, dst, pixels - i);
+}
+#endif
+
+// --- CHỌN KERNEL LÚC CHẠY ---
+int rgb565_supported_kernels(Rgb565Kernel* out, int max) {
+    Rgb565Kernel all[4];
+    int n = 0;
+#ifdef RGB565_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))  all[n++] = { bgr_to_rgb565_avx2,  "avx2" };
+    if (__builtin_cpu_supports("ssse3")) all[n++] = { bgr_to_rgb565_ssse3, "ssse3" };
+#endif
+#ifdef RGB565_NEON
+#if defined(__arm__)
+    if (getauxval(AT_HWCAP) & HWCAP_NEON) all[n++] = { bgr_to_rgb565_neon, "neon" };
+#else
+    all[n++] = { bgr_to_rgb565_neon, "neon" };
+#endif
+#endif
+    all[n++] = { bgr_to_rgb565_scalar, "scalar" };
+
+    if (n > max) n = max;
+    for (int i = 0; i < n; i++) out[i] = all[i];
+    return n;
+}
+
+static Rgb565Kernel pick_kernel() {
+    Rgb565Kernel k;
+    rgb565_supported_kernels(&k, 1);
+    return k;
+}
+
+static const Rgb565Kernel& kernel() {
+    // Khởi tạo 1 lần, an toàn đa luồng (static local C++11)
+    static const Rgb565Kernel k = pick_kernel();
+    return k;
+}
+
+void bgr_to_rgb565(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    kernel().fn(src, dst, pixels);
+}
+
+const char* rgb565_kernel_name() {
+    return kernel().name;
+}
+
+// --- YUYV (YUV 4:2:2 từ camera) -> RGB565 ---
+// Hệ số BT.601 fixed-point 20 bit giống cv::cvtColor(COLOR_YUV2BGR_YUYV)
+// -> cùng màu với đường YUYV -> BGR -> RGB565
+#define YUV_SHIFT 20
+#define YUV_CY    1220542
+#define YUV_CUB   2116026
+#define YUV_CUG   (-409993)
+#define YUV_CVG   (-852492)
+#define YUV_CVR   1673527
+
+static inline uint8_t clamp_u8(int v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline void yuv_pixel(int y, int ruv, int guv, int buv, uint8_t* dst) {
+    y = (y > 16 ? y - 16 : 0) * YUV_CY;
+    uint8_t r = clamp_u8((y + ruv) >> YUV_SHIFT);
+    uint8_t g = clamp_u8((y + guv) >> YUV_SHIFT);
+    uint8_t b = clamp_u8((y + buv) >> YUV_SHIFT);
+    uint16_t c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    dst[0] = c >> 8;
+    dst[1] = c & 0xFF;
+}
+
+static inline void yuv_pair(const uint8_t* src, int u, int v, uint8_t* dst, int n) {
+    int ruv = (1 << (YUV_SHIFT - 1)) + YUV_CVR * v;
+    int guv = (1 << (YUV_SHIFT - 1)) + YUV_CVG * v + YUV_CUG * u;
+    int buv = (1 << (YUV_SHIFT - 1)) + YUV_CUB * u;
+    for (int k = 0; k < n; k++) yuv_pixel(src[2 * k], ruv, guv, buv, dst + 2 * k);
+}
+
+void yuyv_to_rgb565(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    // Mỗi 4 byte Y0 U Y1 V = 2 pixel dùng chung U, V
+    size_t i = 0;
+    for (; i + 1 < pixels; i += 2) {
+        yuv_pair(src, src[1] - 128, src[3] - 128, dst, 2);
+        src += 4;
+        dst += 4;
+    }
+    // pixels lẻ: pixel cuối chỉ còn Y U, không có V -> coi V trung tính
+    if (i < pixels) yuv_pair(src, src[1] - 128, 0, dst, 1);
+}
@@ -0,0 +1,43 @@
+#ifndef RGB565_H
+#define RGB565_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Chuyển BGR888 -> RGB565 Big Endian (đúng thứ tự byte ILI9341 nhận qua SPI)
+// src: pixels * 3 byte, dst: pixels * 2 byte
+// Tự chọn NEON / AVX2 / SSSE3 lúc chạy, không có thì dùng bản scalar
+void bgr_to_rgb565(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// Bản scalar tham chiếu - kết quả SIMD phải giống từng bit
+void bgr_to_rgb565_scalar(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// YUYV (Y0 U Y1 V, width chẵn) -> RGB565 Big Endian trong 1 lượt, không qua BGR.
+// Màu giống cv::cvtColor(COLOR_YUV2BGR_YUYV) rồi bgr_to_rgb565. pixels lẻ: pixel cuối lấy V = 128
+void yuyv_to_rgb565(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// 1 pixel RGB565 dạng uint16 mà byte trong bộ nhớ là Big Endian (giống output ở trên),
+// để vẽ thẳng lên spi_buffer qua cv::Mat CV_16UC1
+static inline uint16_t rgb565_be_pixel(uint8_t b, uint8_t g, uint8_t r) {
+    uint16_t c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    uint8_t bytes[2] = { (uint8_t)(c >> 8), (uint8_t)(c & 0xFF) };
+    uint16_t v;
+    __builtin_memcpy(&v, bytes, 2);
+    return v;
+}
+
+// Tên kernel đang dùng (để in log / benchmark)
+const char* rgb565_kernel_name();
+
+typedef void (*Rgb565Fn)(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+struct Rgb565Kernel {
+    Rgb565Fn fn;
+    const char* name;
+};
+
+// Mọi kernel BGR -> RGB565 mà CPU này chạy được, tốt nhất trước, scalar luôn ở cuối.
+// Trả về số kernel ghi vào out (để test so từng bit với bản scalar)
+int rgb565_supported_kernels(Rgb565Kernel* out, int max);
+
+#endif
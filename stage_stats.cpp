@@ -0,0 +1,92 @@
+#include <string.h>
+#include "stage_stats.h"
+#include "frame_pool.h"
+#include "frame_channel.h"
+#include "queue_helper.h"
+
+StageHist stage_hist[STAGE_COUNT];
+
+static const char* stage_names[STAGE_COUNT] = {
+    "capture", "resize", "wait_ai", "wait_lcd", "detect", "track",
+    "quality", "embed", "capture->result", "rgb565", "overlay", "spi",
+};
+
+// Snapshot lần dump trước -> percentile / FPS tính trên khoảng giữa 2 lần dump
+static uint64_t prev_buckets[STAGE_COUNT][STAGE_BUCKETS];
+static uint64_t prev_dump_ns = 0;
+
+void stage_stats_init() {
+    prev_dump_ns = frame_clock_ns();
+}
+
+uint64_t stage_record_since(StageId s, uint64_t t0) {
+    uint64_t now = frame_clock_ns();
+    stage_record(s, now - t0);
+    return now;
+}
+
+// Cận trên của bucket (báo percentile lệch lên, không bao giờ thấp hơn thực tế)
+static uint64_t bucket_upper(int idx) {
+    if (idx < (1 << STAGE_SUB_BITS)) return (uint64_t)idx;
+    int e = idx >> STAGE_SUB_BITS;
+    uint64_t sub = idx & ((1 << STAGE_SUB_BITS) - 1);
+    return (((1ULL << STAGE_SUB_BITS) + sub + 1) << (e - 1)) - 1;
+}
+
+static double percentile_ms(const uint64_t* delta, uint64_t n, double p, uint64_t max_ns) {
+    uint64_t rank = (uint64_t)(p * n + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < STAGE_BUCKETS; i++) {
+        seen += delta[i];
+        if (seen >= rank) {
+            uint64_t v = bucket_upper(i);
+            return (v < max_ns ? v : max_ns) / 1e6;
+        }
+    }
+    return max_ns / 1e6;
+}
+
+void stage_stats_dump(FILE* f) {
+    uint64_t now = frame_clock_ns();
+    double sec = (now - prev_dump_ns) / 1e9;
+    prev_dump_ns = now;
+
+    fprintf(f, "--- stage stats (%.1f s) ---\n", sec);
+    fprintf(f, "%-16s %8s %7s %9s %9s %9s %9s %9s\n",
+            "stage", "count", "fps", "avg ms", "p50 ms", "p95 ms", "p99 ms", "max ms");
+
+    uint64_t delta[STAGE_BUCKETS];
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        StageHist* h = &stage_hist[s];
+        uint64_t n = 0;
+        for (int i = 0; i < STAGE_BUCKETS; i++) {
+            uint64_t v = h->buckets[i].load(std::memory_order_relaxed);
+            delta[i] = v - prev_buckets[s][i];
+            prev_buckets[s][i] = v;
+            n += delta[i];
+        }
+        uint64_t total = h->count.load(std::memory_order_relaxed);
+        if (n == 0) continue;
+
+        // avg / max tính từ lúc chạy, percentile / fps theo khoảng dump
+        uint64_t max_ns = h->max_ns.load(std::memory_order_relaxed);
+        fprintf(f, "%-16s %8llu %7.1f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                stage_names[s], (unsigned long long)total, sec > 0.0 ? n / sec : 0.0,
+                h->sum_ns.load(std::memory_order_relaxed) / 1e6 / total,
+                percentile_ms(delta, n, 0.50, max_ns), percentile_ms(delta, n, 0.95, max_ns),
+                percentile_ms(delta, n, 0.99, max_ns), max_ns / 1e6);
+    }
+
+    // Mỗi frame chụp được (seq) tới LCD / AI đúng 1 lần, thiếu = bị bỏ ở đâu đó trên đường
+    uint64_t captured = stage_hist[STAGE_CAPTURE].count.load();
+    fprintf(f, "frames: captured %llu | shown %llu | to AI %llu\n",
+            (unsigned long long)captured,
+            (unsigned long long)stage_hist[STAGE_WAIT_LCD].count.load(),
+            (unsigned long long)stage_hist[STAGE_WAIT_AI].count.load());
+    fprintf(f, "drops : pool exhausted %llu | q_display dropped %llu | ai_channel overwritten %llu\n",
+            (unsigned long long)frame_pool.exhausted.load(),
+            (unsigned long long)queue_dropped(&q_display),
+            (unsigned long long)frame_channel_overwritten(&ai_channel));
+    fflush(f);
+}
@@ -0,0 +1,66 @@
+#ifndef STAGE_STATS_H
+#define STAGE_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+
+// Histogram thời gian theo từng stage của pipeline, ghi không khóa từ mọi luồng.
+// Bucket log-tuyến tính: 8 bucket mỗi lũy thừa 2 (sai số percentile <= 12.5%),
+// ghi 1 mẫu = 1 clock_gettime + vài fetch_add relaxed.
+enum StageId {
+    STAGE_CAPTURE = 0,  // Đọc frame từ camera / file
+    STAGE_RESIZE,       // Resize (BGR) / chép YUYV + tách Y vào buffer pool
+    STAGE_WAIT_AI,      // Camera publish -> AI lấy frame (ai_channel)
+    STAGE_WAIT_LCD,     // Camera push -> LCD lấy frame (q_display)
+    STAGE_DETECT,       // Chạy detector
+    STAGE_TRACK,        // Bám box giữa các lần detect
+    STAGE_QUALITY,      // Chọn khuôn mặt + điểm chất lượng
+    STAGE_EMBED,        // FaceNet forward
+    STAGE_RESULT,       // Chụp -> có kết quả AI
+    STAGE_RGB565,       // BGR / YUYV -> RGB565 vào spi_buffer
+    STAGE_OVERLAY,      // Vẽ UI lên spi_buffer (RGB565)
+    STAGE_SPI,          // Gửi 1 frame ra LCD
+    STAGE_COUNT
+};
+
+#define STAGE_SUB_BITS 3
+#define STAGE_MAX_BIT  40  // Mẫu >= 2^41 ns (~36 phút) dồn vào bucket cuối
+#define STAGE_BUCKETS  ((STAGE_MAX_BIT - STAGE_SUB_BITS + 2) << STAGE_SUB_BITS)
+
+typedef struct {
+    std::atomic<uint64_t> buckets[STAGE_BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> max_ns;
+} StageHist;
+
+static inline int stage_bucket(uint64_t ns) {
+    if (ns < (1u << STAGE_SUB_BITS)) return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    if (msb > STAGE_MAX_BIT) return STAGE_BUCKETS - 1;
+    return ((msb - STAGE_SUB_BITS + 1) << STAGE_SUB_BITS) |
+           (int)((ns >> (msb - STAGE_SUB_BITS)) & ((1 << STAGE_SUB_BITS) - 1));
+}
+
+extern StageHist stage_hist[STAGE_COUNT];
+
+static inline void stage_record(StageId s, uint64_t ns) {
+    StageHist* h = &stage_hist[s];
+    h->buckets[stage_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    h->count.fetch_add(1, std::memory_order_relaxed);
+    h->sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t m = h->max_ns.load(std::memory_order_relaxed);
+    while (ns > m && !h->max_ns.compare_exchange_weak(m, ns, std::memory_order_relaxed)) {}
+}
+
+// Mốc thời gian cho lần dump đầu tiên
+void stage_stats_init();
+
+// Ghi từ mốc t0 (frame_clock_ns) tới bây giờ, trả về thời điểm hiện tại để nối stage kế tiếp
+uint64_t stage_record_since(StageId s, uint64_t t0);
+
+// In percentile + FPS mỗi stage kể từ lần dump trước (chỉ 1 luồng được gọi), kèm bộ đếm drop
+void stage_stats_dump(FILE* f);
+
+#endif
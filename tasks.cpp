@@ -1,14 +1,34 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include <vector>
 #include <mutex>
+#include <pthread.h>
 #include <string>
 
 #include "tasks.h"
 #include "queue_helper.h"
 #include "lcd_driver.h"
+#include "lcd_pipeline.h"
+#include "lcd_overlay.h"
+#include "rgb565.h"
+#include "frame_pool.h"
+#include "frame_channel.h"
+#include "alloc_trace.h"
 #include "config.h"
 #include "facenet.h" 
+#include "face_gallery.h"
+#include "embedding_store.h"
+#include "face_tracker.h"
+#include "face_detector.h"
+#include "face_job.h"
+#include "face_quality.h"
+#include "camera_source.h"
+#include "mjpeg_decoder.h"
+#include "stage_stats.h"
+#include "detection_filter.h"
 //Tổng quan hệ thống 3 task chạy song song
 // --- DỮ LIỆU CHIA SẺ (SHARED DATA) ---
 
@@ -22,21 +42,25 @@ struct AIResult {
 };
 
 // Biến toàn cục và Mutex bảo vệ
-// Biến toàn cục và Mutex bảo vệ
+// Frame cho AI đi qua ai_channel (frame_channel.h), mutex chỉ còn bảo vệ kết quả
 std::mutex mtx_ai;              // Khóa an toàn
-cv::Mat shared_ai_frame;        // Frame mới nhất để AI xử lý
-bool new_frame_for_ai = false;  // Cờ báo có ảnh mới
 AIResult shared_result;         // Kết quả AI để LCD hiển thị
 
 // Đối tượng FaceNet và biến lưu chủ nhân
 // Lưu trữ nhiều embeddings cho việc đăng ký
-std::vector<cv::Mat> owner_face_samples;  // Lưu ảnh mẫu
-FaceNet faceNet;
-cv::Mat owner_embedding;
+std::vector<EnrollSample> owner_face_samples;  // Ảnh mẫu + embedding + quality (tính 1 lần)
+cv::Mat owner_sample_embs;                      // N x D: embedding các mẫu xếp liền nhau để so sánh 1 lần
+FaceNet faceNets[AI_RECOG_THREADS];       // faceNets[i] cho luồng Recognize i
+FaceGallery gallery;                       // Tất cả danh tính đã đăng ký
+EmbeddingStore emb_store;                  // File lưu gallery (mmap)
+const char* enroll_name = NULL;            // Tên người đang đăng ký (NULL = tự đặt "User N")
+int last_match = -1;                       // Danh tính khớp ở frame trước (đổi người -> reset bộ lọc)
 bool has_owner = false;
+std::mutex mtx_state;                      // Bảo vệ trạng thái đăng ký / gallery / bộ lọc giữa các luồng Recognize
 const int REQUIRED_SAMPLES = 10;           // Cần 15 mẫu tốt để đăng ký
 const int MIN_FRAME_GAP = 15;             // Chờ 15 frame giữa các mẫu
 int frame_counter_since_last_sample = 0;  // Đếm frame
+bool enroll_busy = false;                  // 1 luồng đang chạy registerOwner ngoài khóa
 
 // Thống kê để debug
 struct RegistrationStats {
@@ -75,47 +99,7 @@ struct RegistrationStats {
 
 RegistrationStats reg_stats;
 
-// Bộ lọc kết quả
-struct DetectionFilter {
-    std::vector<float> recent_similarities;
-    const int WINDOW_SIZE = 7;  // Tăng lên 7 frame
-    
-    bool isStable(float new_similarity) {
-        recent_similarities.push_back(new_similarity);
-        if (recent_similarities.size() > (size_t)WINDOW_SIZE) {
-            recent_similarities.erase(recent_similarities.begin());
-        }
-        
-        if (recent_similarities.size() < 5) return false;
-        
-        // Tính độ lệch chuẩn
-        float mean = 0;
-        for (float s : recent_similarities) mean += s;
-        mean /= recent_similarities.size();
-        
-        float variance = 0;
-        for (float s : recent_similarities) {
-            variance += (s - mean) * (s - mean);
-        }
-        variance /= recent_similarities.size();
-        float stddev = sqrt(variance);
-        
-        // Ổn định nếu stddev < 0.05
-        return stddev < 0.05f;
-    }
-    
-    float getAverage() {
-        if (recent_similarities.empty()) return 0.0f;
-        float sum = 0;
-        for (float s : recent_similarities) sum += s;
-        return sum / recent_similarities.size();
-    }
-    
-    void clear() {
-        recent_similarities.clear();
-    }
-};
-
+// Bộ lọc kết quả (detection_filter.h)
 DetectionFilter detection_filter;
 
 // === HÀM HỖ TRỢ CẢI TIẾN ===
@@ -136,26 +120,28 @@ bool isFaceAligned(const cv::Rect& face, const cv::Mat& frame) {
     return true;
 }
 
-cv::Rect selectBestFace(const std::vector<cv::Rect>& faces, 
-                         const cv::Mat& frame,
-                         FaceNet& faceNet) {
-    if (faces.empty()) return cv::Rect();
+// Quality tính 1 lượt trên ảnh xám của frame (đã có sẵn), giữ lại cùng box được chọn
+FaceCandidate selectBestFace(const std::vector<cv::Rect>& faces,
+                             const cv::Mat& gray) {
+    FaceCandidate best_face;
+    best_face.quality = 0.0f;
+    if (faces.empty()) return best_face;
     
     float best_score = -1.0f;
-    cv::Rect best_face;
     
     for (const auto& face : faces) {
-        if (!isFaceAligned(face, frame)) continue;
+        if (!isFaceAligned(face, gray)) continue;
         
-        cv::Mat face_roi = frame(face);
-        float quality = faceNet.checkQuality(face_roi);
+        const uint8_t* roi = gray.ptr<uint8_t>(face.y) + face.x;
+        float quality = face_quality_gray(roi, face.width, face.height, gray.step);
         float size_score = std::min(1.0f, (face.width * face.height) / 12000.0f);
         
         float total_score = quality * 0.8f + size_score * 0.2f;
         
         if (total_score > best_score) {
             best_score = total_score;
-            best_face = face;
+            best_face.box = face;
+            best_face.quality = quality;
         }
     }
     
@@ -163,19 +149,17 @@ cv::Rect selectBestFace(const std::vector<cv::Rect>& faces,
 }
 
 // Kiểm tra mẫu có đủ khác biệt không
-bool isSampleDiverse(const cv::Mat& new_sample, FaceNet& faceNet) {
-    if (owner_face_samples.size() < 2) return true;
-    
-    cv::Mat new_emb = faceNet.getEmbedding(new_sample);
+// new_emb: embedding của mẫu mới (forward ngoài mtx_state, dùng lại khi lưu mẫu)
+bool isSampleDiverse(const cv::Mat& new_emb) {
     if (new_emb.empty()) return false;
+
+    if (owner_face_samples.size() < 2) return true;
     
-    // So sánh với mẫu cuối cùng
-    cv::Mat last_sample = owner_face_samples.back();
-    cv::Mat last_emb = faceNet.getEmbedding(last_sample);
-    
-    if (last_emb.empty()) return false;
-    
-    float similarity = faceNet.cosineSimilarity(new_emb, last_emb);
+    // So sánh với TẤT CẢ mẫu đã lưu: (N x D) * (D x 1) = N cosine similarity
+    cv::Mat sims = owner_sample_embs * new_emb.reshape(1, 1).t();
+    double max_sim;
+    cv::minMaxLoc(sims, NULL, &max_sim);
+    float similarity = (float)max_sim;
     reg_stats.similarities.push_back(similarity);
     
     // Nếu quá giống (>0.95) thì từ chối
@@ -184,10 +168,25 @@ bool isSampleDiverse(const cv::Mat& new_sample, FaceNet& faceNet) {
         return false;
     }
     
-    printf("[Diversity Check] Similarity: %.3f - OK\n", similarity);
+    printf("[Diversity Check] Max similarity: %.3f - OK\n", similarity);
     return true;
 }
 
+// Lưu mẫu đã qua kiểm tra cùng embedding và quality
+void addEnrollSample(const cv::Mat& face_roi, const cv::Mat& emb, float quality) {
+    EnrollSample sample;
+    sample.face = face_roi.clone();
+    sample.embedding = emb;
+    sample.quality = quality;
+    owner_face_samples.push_back(sample);
+    owner_sample_embs.push_back(emb.reshape(1, 1));
+}
+
+void clearEnrollSamples() {
+    owner_face_samples.clear();
+    owner_sample_embs.release();
+}
+
 
 
 // --- TASK 1: CAMERA (PRODUCER) ---
@@ -196,178 +195,390 @@ bool isSampleDiverse(const cv::Mat& new_sample, FaceNet& faceNet) {
 ✔ Mở camera
 ✔ Lấy frame liên tục
 ✔ Đẩy frame vào queue hiển thị
-✔ Gửi frame cho AI xử lý (shared frame)*/
+✔ Gửi frame cho AI xử lý (ai_channel)
+✔ Dừng (Ctrl+C) -> đóng queue + channel để các luồng khác thoát*/
 void* task_camera(void* arg) {
-    // Mở Camera (Ưu tiên V4L2 trên Linux/Pi)
-    cv::VideoCapture cap(0, cv::CAP_V4L2);
-
-    // Cấu hình cứng độ phân giải khớp với LCD để không phải resize
-    cap.set(cv::CAP_PROP_FRAME_WIDTH, LCD_WIDTH);  // 320
-    cap.set(cv::CAP_PROP_FRAME_HEIGHT, LCD_HEIGHT); // 240
-    cap.set(cv::CAP_PROP_FPS, 30);
-
-
-    if (!cap.isOpened()) {
-        printf("[Task Cam] Error: Cannot open camera! Check connection.\n");
-        return NULL;
+    // Nguồn frame: camera thật, hoặc replay video / thư mục ảnh (REPLAY_SOURCE)
+    const char* replay = getenv("REPLAY_SOURCE");
+    const char* rate = getenv("REPLAY_RATE");
+    const char* frames_env = getenv("REPLAY_FRAMES");
+    uint64_t max_frames = frames_env ? strtoull(frames_env, NULL, 10) : 0;   // 0 = chạy tới hết nguồn
+    int throttle = !(rate && strcmp(rate, "max") == 0);
+    int live = !(replay && replay[0]);
+
+    // Camera thật: CAMERA_BACKEND=v4l2 lấy YUYV thẳng từ driver (không decode, không resize),
+    // CAMERA_BACKEND=mjpeg lấy JPEG rồi giải nén thu nhỏ bằng IDCT; không được thì lùi về cv::VideoCapture
+    const char* backend = getenv("CAMERA_BACKEND");
+    const char* device = getenv("CAMERA_DEVICE");
+    if (!backend || !backend[0]) backend = CAMERA_BACKEND_DEFAULT;
+    if (!device || !device[0]) device = CAMERA_DEVICE_DEFAULT;
+
+    // Cần N frame -> nguồn ngắn hơn thì đọc vòng lại
+    CameraSource source;
+    int opened = 0;
+    if (live && (strcmp(backend, "v4l2") == 0 || strcmp(backend, "mjpeg") == 0)) {
+        uint32_t pixfmt = strcmp(backend, "mjpeg") == 0 ? V4L2_PIX_FMT_MJPEG : V4L2_PIX_FMT_YUYV;
+        opened = camera_source_open_v4l2(&source, device, pixfmt, max_frames > 0);
+        if (!opened) printf("[Task Cam] V4L2 %s unavailable, falling back to OpenCV\n", device);
+    }
+    if (!opened && !camera_source_open(&source, replay, throttle, max_frames > 0)) {
+        printf("[Task Cam] Error: Cannot open %s! Check connection.\n", live ? "camera" : replay);
+        app_running = 0;
+    } else if (!live) {
+        printf("[Task Cam] Replay %s | rate %s | frames %s\n", replay, throttle ? "native" : "max",
+               max_frames ? frames_env : "all");
     }
 
     cv::Mat cam_frame;
-    cv::Mat frame;
-    printf("[Task Cam] Started successfully\n");
-
-    while(1) {
-        cap >> cam_frame;
-        cv::resize(cam_frame, frame, cv::Size(LCD_WIDTH, LCD_HEIGHT));   
-        if (frame.empty()) {
+    CameraFormat format = camera_source_format(&source);
+    MjpegDecoder jpeg;              // CAMERA_FORMAT_MJPEG
+    if (format == CAMERA_FORMAT_MJPEG && !mjpeg_decoder_init(&jpeg)) {
+        printf("[Task Cam] Error: libjpeg init failed\n");
+        app_running = 0;
+    }
+    uint64_t frame_count = 0;
+    uint64_t allocs_mark = 0;
+    if (app_running) printf("[Task Cam] Started successfully\n");
+
+    uint64_t frame_seq = 0;
+    uint64_t t_begin = frame_clock_ns();
+    while(app_running) {
+        uint64_t t_grab = frame_clock_ns();
+        int r = camera_source_read(&source, cam_frame);
+        if (r == 0) {
+            app_running = 0;                // Hết file replay -> dừng như Ctrl+C
+            break;
+        }
+        if (r < 0) {
             usleep(10000);
             continue;
         }
+        uint64_t t_captured = stage_record_since(STAGE_CAPTURE, t_grab);
+        frame_seq++;
 
-        // 1. Đẩy vào hàng đợi hiển thị (Queue Display)
-        // Clone() là bắt buộc để tránh xung đột vùng nhớ
-        queue_push(&q_display, frame.clone());
-
-        // 2. Cập nhật frame cho AI (Ghi đè frame cũ nếu AI chưa xử lý kịp)
-        {
-            std::lock_guard<std::mutex> lock(mtx_ai);
-            shared_ai_frame = frame.clone();
-            new_frame_for_ai = true;
+        // Lấy buffer từ pool (hết buffer = mọi luồng đang giữ frame -> bỏ frame này)
+        FrameHandle frame = frame_pool_acquire(&frame_pool);
+        if (frame.empty()) {
+            usleep(1000);
+            continue;
+        }
+        frame.setCaptureNs(t_captured);
+        frame.setSeq(frame_seq);
+        uint64_t t_resize = frame_clock_ns();
+        if (format == CAMERA_FORMAT_YUYV) {
+            // Chép YUYV ra khỏi buffer mmap (trả lại driver ở lần đọc sau), kênh Y chính là ảnh xám
+            cam_frame.copyTo(frame.yuyv());
+            cv::extractChannel(frame.yuyv(), frame.gray(), 0);
+            frame.setFormat(FRAME_FORMAT_YUYV);
+        } else if (format == CAMERA_FORMAT_MJPEG) {
+            // IDCT thu nhỏ ghi thẳng vào buffer pool; camera không cho đúng tỉ lệ thì resize phần còn lại
+            cv::Mat& dst = frame.mat();
+            int dec = mjpeg_decode(&jpeg, cam_frame.data, cam_frame.total(), dst.data, dst.cols, dst.rows, dst.step);
+            if (dec == MJPEG_DECODE_FAILED) continue;   // Frame hỏng: handle rỗng trả buffer về pool
+            if (dec == MJPEG_DECODE_SCRATCH) {
+                cv::resize(cv::Mat(jpeg.out_h, jpeg.out_w, CV_8UC3, jpeg.scratch), dst,
+                           cv::Size(LCD_WIDTH, LCD_HEIGHT), 0, 0, cv::INTER_AREA);
+            }
+            frame.setFormat(FRAME_FORMAT_BGR);
+        } else {
+            // Resize thẳng vào buffer của pool (cùng kích thước -> không cấp phát lại)
+            cv::resize(cam_frame, frame.mat(), cv::Size(LCD_WIDTH, LCD_HEIGHT));
+            frame.setFormat(FRAME_FORMAT_BGR);
+        }
+        frame.setPublishNs(stage_record_since(STAGE_RESIZE, t_resize));
+
+        // 1. Đẩy vào hàng đợi hiển thị (Queue Display) - chỉ tăng tham chiếu
+        queue_push(&q_display, frame);
+
+        // 2. Cập nhật frame cho AI (Ghi đè frame cũ nếu AI chưa xử lý kịp) và đánh thức AI
+        frame_channel_publish(&ai_channel, frame);
+
+        // Đếm cấp phát heap mỗi frame (make ALLOC_TRACE=1)
+        if (++frame_count % LCD_STATS_INTERVAL == 0) {
+            uint64_t allocs = alloc_trace_thread_count();
+            printf("[Task Cam] Heap allocs/frame: %.2f | pool free: %d | pool exhausted: %llu\n",
+                   (double)(allocs - allocs_mark) / LCD_STATS_INTERVAL,
+                   frame_pool_available(&frame_pool),
+                   (unsigned long long)frame_pool.exhausted.load());
+            allocs_mark = allocs;
         }
 
+        // Đủ REPLAY_FRAMES -> dừng cả hệ thống như Ctrl+C
+        if (max_frames && frame_count >= max_frames) app_running = 0;
+
         // Ngủ nhẹ để giảm tải CPU nếu cần (tùy chọn)
-        usleep(1000); 
+        if (live) usleep(1000);
+    }
+
+    if (!live && frame_count > 0) {
+        double sec = (frame_clock_ns() - t_begin) / 1e9;
+        printf("[Task Cam] Replayed %llu frames in %.2f s (%.1f fps)\n",
+               (unsigned long long)frame_count, sec, frame_count / sec);
+    }
+    if (format == CAMERA_FORMAT_MJPEG) {
+        if (jpeg.errors) printf("[Task Cam] MJPEG: %llu corrupt frames skipped\n", (unsigned long long)jpeg.errors);
+        mjpeg_decoder_free(&jpeg);
     }
+    camera_source_close(&source);
+
+    // Báo các luồng phía sau: không còn frame nữa
+    frame_channel_close(&ai_channel);
+    queue_close(&q_display);
+    printf("[Task Cam] Stopped\n");
     return NULL;
 }
 
 
 // --- TASK 2: AI PROCESSING (BACKGROUND) ---
-//AI Thread -->  đọc shared frame -> detect face -> embed -> compare
+//AI Thread -->  đọc frame mới nhất -> detect face -> embed -> compare
 /*Nhiệm vụ:
-1️⃣ Load model MobileFaceNet
-2️⃣ Load Haar cascade để detect face
-3️⃣ Lấy frame từ thread Camera
-🔍 AI xử lý gồm 3 bước lớn
-Bước A: Detect Face
-Bước B: Lấy embedding từ khuôn mặt lớn nhất
-Bước C: So sánh embedding để nhận diện
-Nếu chưa có chủ nhân (has_owner = false)
-Nếu đã có chủ nhân → So sánh cosine distance
-4️⃣ Cập nhật kết quả cho LCD
+1️⃣ Load model MobileFaceNet (mỗi luồng Recognize 1 bản)
+2️⃣ Tạo detector cho mỗi luồng Detect
+3️⃣ Lấy frame từ thread Camera (ai_channel)
+🔍 AI chia thành 2 stage chạy song song, nối bằng face_jobs (có giới hạn):
+Stage Detect   : ảnh xám (kênh Y / cvtColor) -> track/detect -> chọn khuôn mặt tốt nhất + quality
+Stage Recognize: embedding -> đăng ký / so sánh cosine với gallery
+=> Detect frame N+1 trong lúc Recognize frame N, throughput = stage chậm nhất
+4️⃣ Cập nhật kết quả cho LCD (theo thứ tự frame)
 */
-// === TASK AI NÂNG CẤP ===
 // === TASK AI FINAL VERSION ===
 
-void* task_ai_improved(void* arg) {
-    printf("[Task AI] Loading Models...\n");
-    
-    // Load Model
-    try {
-        faceNet.loadModel("MobileFaceNet.onnx");
-        if (!faceNet.isLoaded()) {
-            printf("[Task AI] CRITICAL: Model load failed!\n");
-            return NULL;
-        }
-    } catch (const cv::Exception& e) {
-        printf("[Task AI] Error: %s\n", e.what());
-        return NULL;
-    }
-    
-    // Load Haar Cascade
-    cv::CascadeClassifier face_cascade;
-    if(!face_cascade.load("/home/pi/opencv/data/haarcascades/haarcascade_frontalface_default.xml")) {
-        if(!face_cascade.load("haarcascade_frontalface_default.xml")) {
-            printf("[Task AI] Error: Cannot load cascade!\n");
-            return NULL;
-        }
+static FaceJobQueue face_jobs;          // Detect -> Recognize
+static uint64_t filter_seq = 0;         // seq của frame cuối cùng cập nhật detection_filter (bảo vệ bởi mtx_state)
+static uint64_t published_seq = 0;      // seq của frame có kết quả đã publish (bảo vệ bởi mtx_ai)
+
+// Nhiều luồng Recognize có thể xong lệch thứ tự: bỏ kết quả của frame cũ hơn frame đã publish
+static void publishResult(const AIResult& result, uint64_t seq) {
+    std::lock_guard<std::mutex> lock(mtx_ai);
+    if (seq < published_seq) return;
+    published_seq = seq;
+    shared_result = result;
+}
+
+// Giống publishResult: frame cũ hơn frame đã cập nhật bộ lọc thì không đưa vào bộ lọc,
+// để bộ lọc ổn định thấy similarity theo thứ tự frame dù AI_RECOG_THREADS > 1. Gọi khi giữ mtx_state
+static bool filterAccepts(uint64_t seq) {
+    if (seq < filter_seq) return false;
+    filter_seq = seq;
+    return true;
+}
+
+static int ai_wait_poll = 0;             // AI_WAIT=poll (chỉ để đo so sánh)
+
+// Lấy frame tiếp theo từ ai_channel: 1 = có frame, 0 = kênh đã đóng.
+// AI_WAIT=poll tái hiện vòng lặp cũ: ngủ 5 ms sau frame trước, chưa có frame thì ngủ 10 ms rồi xem lại
+static int next_ai_frame(FrameHandle* out, bool after_frame) {
+    if (!ai_wait_poll) return frame_channel_wait(&ai_channel, out);
+
+    if (after_frame) usleep(AI_POLL_AFTER_US);
+    while (1) {
+        int r = frame_channel_poll(&ai_channel, out);
+        if (r != 0) return r > 0;
+        usleep(AI_POLL_US);
     }
+}
 
+// --- Stage Detect: mỗi luồng có detector + tracker riêng ---
+static void* task_ai_detect(void* arg) {
+    FaceDetector* detector = (FaceDetector*)arg;
+    FrameHandle process_handle;     // Giữ buffer pool trong lúc xử lý
     cv::Mat process_frame;
-    printf("[Task AI] ===== FINAL VERSION LOADED =====\n");
-    printf("[Task AI] Using: Cosine Similarity | Augmentation | Diversity Check\n\n");
+    cv::Mat gray;                   // Trỏ vào gray của frame pool hoặc gray_buf
+    cv::Mat gray_buf;
+    cv::Mat color;                  // BGR dựng từ YUYV (chỉ khi detector cần)
+    FaceTracker tracker;            // Bám khuôn mặt giữa các lần detect
+    std::vector<float> scores;
+
+    // Thống kê tỉ lệ detect-track
+    int stat_frames = 0, stat_detect = 0, stat_track = 0;
+    double stat_detect_ms = 0.0;
 
     while(1) {
-        bool has_new = false;
+        // Trả buffer frame trước về pool rồi ngủ tới khi Camera publish frame mới
+        bool after_frame = !process_handle.empty();
+        process_handle.reset();
+        if (!next_ai_frame(&process_handle, after_frame)) break;
+        stage_record_since(STAGE_WAIT_AI, process_handle.publishNs());
+        FaceJob job;
+        job.t_start = cv::getTickCount();
+        job.best.quality = 0.0f;
+
+        // Chỉ đọc, không vẽ lên frame này (LCD dùng chung buffer).
+        // Frame YUYV: kênh Y camera đã tách sẵn làm ảnh xám; chỉ dựng BGR khi detector cần màu
+        if (process_handle.format() == FRAME_FORMAT_YUYV) {
+            gray = process_handle.gray();
+            if (detector->needsColor()) {
+                cv::cvtColor(process_handle.yuyv(), color, cv::COLOR_YUV2BGR_YUYV);
+                process_frame = color;
+            } else {
+                process_frame = cv::Mat();
+            }
+        } else {
+            process_frame = process_handle.mat();
+            cv::cvtColor(process_frame, gray_buf, cv::COLOR_BGR2GRAY);
+            gray = gray_buf;
+        }
 
-        // Lấy frame
-        {
-            std::lock_guard<std::mutex> lock(mtx_ai);
-            if (new_frame_for_ai) {
-                process_frame = shared_ai_frame.clone();
-                new_frame_for_ai = false;
-                has_new = true;
+        // Bám box cũ nếu còn tin cậy, chỉ chạy detector khi mất dấu hoặc hết TRACK_MAX_FRAMES
+        bool tracked = false;
+        if (TRACK_ENABLE && tracker.active() && tracker.framesTracked() < TRACK_MAX_FRAMES) {
+            cv::Rect box;
+            float score;
+            uint64_t t_track = frame_clock_ns();
+            bool ok = tracker.update(gray, box, score);
+            stage_record_since(STAGE_TRACK, t_track);
+            if (ok) {
+                job.faces.push_back(box);
+                tracked = true;
             }
         }
 
-        if (!has_new) {
-            usleep(10000);
-            continue;
+        if (tracked) {
+            stat_track++;
+        } else {
+            tracker.stop();
+            stat_detect++;
+            uint64_t t_detect = frame_clock_ns();
+            detector->detect(process_frame, gray, job.faces, scores);
+            stat_detect_ms += (stage_record_since(STAGE_DETECT, t_detect) - t_detect) / 1e6;
         }
 
-        frame_counter_since_last_sample++;
+        if (!job.faces.empty()) {
+            uint64_t t_quality = frame_clock_ns();
+            job.best = selectBestFace(job.faces, gray);
+            stage_record_since(STAGE_QUALITY, t_quality);
+
+            if (TRACK_ENABLE) {
+                if (job.best.box.area() == 0) tracker.stop();  // Box bám bị loại -> detect lại frame sau
+                else if (!tracked) tracker.start(gray, job.best.box);
+            }
+        }
 
+        // Giao frame + box cho stage Recognize (chờ nếu Recognize đang chậm hơn)
+        job.frame = std::move(process_handle);
+        if (!face_job_queue_push(&face_jobs, job)) break;
+
+        if (++stat_frames % AI_STATS_INTERVAL == 0) {
+            printf("[Task AI] Detect %d / track %d (%.0f%% tracked) | %s %.1f ms/detect\n",
+                   stat_detect, stat_track, 100.0 * stat_track / AI_STATS_INTERVAL, detector->name(),
+                   stat_detect ? stat_detect_ms / stat_detect : 0.0);
+            stat_detect_ms = 0.0;
+            stat_detect = stat_track = 0;
+        }
+    }
+    return NULL;
+}
+
+// --- Stage Recognize: mỗi luồng có FaceNet riêng, trạng thái đăng ký/lọc dùng chung qua mtx_state ---
+static void* task_ai_recognize(void* arg) {
+    FaceNet& net = *(FaceNet*)arg;
+    FaceJob job;
+
+    // Thống kê latency (bắt đầu detect -> có kết quả) và chụp -> có kết quả
+    int stat_frames = 0;
+    double stat_ms_sum = 0.0, stat_ms_max = 0.0;
+    double stat_e2e_sum = 0.0, stat_e2e_max = 0.0;
+
+    while (face_job_queue_pop(&face_jobs, &job)) {
         // === XỬ LÝ AI ===
         AIResult local_result;
         local_result.has_detection = false;
         local_result.message = "Scanning...";
         local_result.color = cv::Scalar(0, 255, 255);
-        
-        // Detect faces
-        std::vector<cv::Rect> faces;
-        cv::Mat gray;
-        cv::cvtColor(process_frame, gray, cv::COLOR_BGR2GRAY);
-        
-        face_cascade.detectMultiScale(
-            gray, faces,
-            1.05, 5, 0,
-            cv::Size(60, 60),
-            cv::Size(240, 240)
-        );
-
-        if (!faces.empty()) {
-            cv::Rect best_face = selectBestFace(faces, process_frame, faceNet);
-            
+
+        std::unique_lock<std::mutex> lock(mtx_state);
+        frame_counter_since_last_sample++;
+
+        if (!job.faces.empty()) {
+            cv::Rect best_face = job.best.box;
+
             if (best_face.area() > 0) {
                 local_result.has_detection = true;
                 local_result.faces.push_back(best_face);
-                
-                cv::Mat face_roi = process_frame(best_face);
-                float quality = faceNet.checkQuality(face_roi);
-                
+
+                cv::Mat face_roi = job.crop();
+                float quality = job.best.quality;     // Đã tính ở stage Detect
+
                 // === ĐĂNG KÝ CHỦ NHÂN ===
                 if (!has_owner) {
                     // Yêu cầu: Quality cao + Đợi đủ frame gap + Đa dạng
-                    if (quality > 0.55f && frame_counter_since_last_sample >= MIN_FRAME_GAP) {
-                        
+                    if (enroll_busy) {
+                        local_result.message = "Registering...";
+                        local_result.color = cv::Scalar(255, 200, 0);
+                    } else if (quality > 0.55f && frame_counter_since_last_sample >= MIN_FRAME_GAP) {
+                        // Forward FaceNet ngoài khóa: các luồng Recognize khác vẫn chạy song song
+                        lock.unlock();
+                        cv::Mat sample_emb = net.getEmbedding(face_roi);
+                        lock.lock();
+
+                        // Trong lúc forward, luồng khác có thể đã thêm mẫu (reset gap) hoặc đăng ký xong -> bỏ mẫu này
+                        bool still_enrolling = !has_owner && !enroll_busy &&
+                                               frame_counter_since_last_sample >= MIN_FRAME_GAP;
+
                         // Kiểm tra độ đa dạng
-                        if (isSampleDiverse(face_roi, faceNet)) {
-                            owner_face_samples.push_back(face_roi.clone());
+                        if (!still_enrolling) {
+                            local_result.message = "Registering...";
+                            local_result.color = cv::Scalar(255, 200, 0);
+                        } else if (isSampleDiverse(sample_emb)) {
+                            addEnrollSample(face_roi, sample_emb, quality);
                             reg_stats.addSample(quality);
                             frame_counter_since_last_sample = 0;
-                            
+                        
                             int progress = (owner_face_samples.size() * 100) / REQUIRED_SAMPLES;
                             local_result.message = "Register: " + std::to_string(progress) + "%";
                             local_result.color = cv::Scalar(255, 200, 0);
-                            
+                        
                             printf("[Register] Sample %zu/%d | Q: %.2f | Gap: OK\n", 
                                    owner_face_samples.size(), REQUIRED_SAMPLES, quality);
-                            
+                        
                             // Đủ mẫu
                             if (owner_face_samples.size() >= REQUIRED_SAMPLES) {
                                 printf("\n[Register] Processing samples...\n");
-                                owner_embedding = faceNet.registerOwner(owner_face_samples);
-                                
+                                // registerOwner forward mọi biến thể augmentation -> chạy ngoài khóa trên bản sao,
+                                // enroll_busy chặn luồng khác thêm mẫu / đăng ký lần 2 trong lúc đó
+                                std::vector<EnrollSample> samples = owner_face_samples;
+                                enroll_busy = true;
+                                lock.unlock();
+                                cv::Mat owner_embedding = net.registerOwner(samples);
+                                lock.lock();
+                                enroll_busy = false;
+                            
                                 if (!owner_embedding.empty()) {
+                                    if (gallery.dim() != (int)owner_embedding.total()) {
+                                        gallery.init((int)owner_embedding.total());
+                                        gallery.setInt8(GALLERY_INT8);
+                                    }
+                                    std::string name = enroll_name ? enroll_name :
+                                                       "User " + std::to_string(gallery.size() + 1);
+                                    const float* emb = (const float*)owner_embedding.data;
+                                    int dim = (int)owner_embedding.total();
+
+                                    // Ghi xuống file rồi cho gallery trỏ vào vùng mmap mới.
+                                    // Không ghi được / không map lại được: store giữ nguyên vùng mmap cũ
+                                    // nên gallery đang trỏ vào vẫn hợp lệ, add() copy sang RAM rồi thêm
+                                    int stored = embedding_store_append(&emb_store, name.c_str(), emb, dim);
+                                    if (stored == EMB_STORE_APPENDED) {
+                                        embedding_store_attach(&emb_store, &gallery);
+                                    } else {
+                                        if (stored == EMB_STORE_NOT_REMAPPED) {
+                                            printf("[Register] '%s' saved, in RAM until restart\n", name.c_str());
+                                        } else {
+                                            printf("[Register] '%s' not saved, kept in RAM only\n", name.c_str());
+                                        }
+                                        gallery.add(name.c_str(), emb);
+                                    }
                                     has_owner = true;
+                                    enroll_name = NULL;
+                                    printf("[Register] Enrolled '%s' (%d identities, kernel: %s)\n",
+                                           name.c_str(), gallery.size(), FaceGallery::kernelName());
                                     local_result.message = "REGISTRATION COMPLETE!";
                                     local_result.color = cv::Scalar(0, 255, 0);
-                                    
+                                
                                     reg_stats.printStats();
                                     printf("[Register] ==> SUCCESS <==\n\n");
                                 } else {
                                     printf("[Register] Failed! Retrying...\n");
-                                    owner_face_samples.clear();
+                                    clearEnrollSamples();
                                     reg_stats.clear();
                                     frame_counter_since_last_sample = 0;
                                 }
@@ -390,30 +601,42 @@ void* task_ai_improved(void* arg) {
                 // === NHẬN DIỆN ===
                 else {
                     if (quality > 0.45f) {
-                        cv::Mat current_embedding = faceNet.getEmbedding(face_roi);
+                        // Forward FaceNet ngoài khóa: các luồng Recognize khác vẫn chạy song song
+                        lock.unlock();
+                        uint64_t t_embed = frame_clock_ns();
+                        cv::Mat current_embedding = net.getEmbedding(face_roi);
+                        stage_record_since(STAGE_EMBED, t_embed);
+                        lock.lock();
+                    
+                        GalleryMatch match;
+                        if (filterAccepts(job.frame.seq()) && !current_embedding.empty() &&
+                            (int)current_embedding.total() == gallery.dim() &&
+                            gallery.search((const float*)current_embedding.data, 1, &match) == 1) {
+                            float similarity = match.score;
+                            const char* match_name = gallery.name(match.index);
+
+                            // Đổi danh tính gần nhất -> bắt đầu lọc lại từ đầu
+                            if (match.index != last_match) {
+                                detection_filter.clear();
+                                last_match = match.index;
+                            }
                         
-                        if (!current_embedding.empty()) {
-                            float similarity = faceNet.cosineSimilarity(
-                                current_embedding, 
-                                owner_embedding
-                            );
-                            
                             // Lọc ổn định
                             bool is_stable = detection_filter.isStable(similarity);
                             float avg_similarity = detection_filter.getAverage();
-                            
+                        
                             // QUAN TRỌNG: Threshold cao hơn cho Cosine Similarity
                             const float THRESHOLD = 0.90f;  // >= 0.90 = cùng người
-                            
+                        
                             if (is_stable) {
                                 if (avg_similarity >= THRESHOLD) {
-                                    local_result.message = "ACCESS GRANTED";
+                                    local_result.message = std::string("ACCESS GRANTED: ") + match_name;
                                     local_result.color = cv::Scalar(0, 255, 0);
-                                    printf("[VERIFY] ✓ OWNER (Sim: %.3f)\n", avg_similarity);
+                                    printf("[VERIFY] ✓ %s (Sim: %.3f)\n", match_name, avg_similarity);
                                 } else {
                                     local_result.message = "ACCESS DENIED";
                                     local_result.color = cv::Scalar(0, 0, 255);
-                                    printf("[VERIFY] ✗ UNKNOWN (Sim: %.3f)\n", avg_similarity);
+                                    printf("[VERIFY] ✗ UNKNOWN (closest: %s, Sim: %.3f)\n", match_name, avg_similarity);
                                 }
                             } else {
                                 local_result.message = "Analyzing... (" + 
@@ -430,114 +653,317 @@ void* task_ai_improved(void* arg) {
             }
         } else {
             local_result.message = "No Face";
-            detection_filter.clear();
+            if (filterAccepts(job.frame.seq())) {
+                detection_filter.clear();
+                last_match = -1;
+            }
             frame_counter_since_last_sample = 0;
         }
+        lock.unlock();
 
         // Cập nhật kết quả
-        {
-            std::lock_guard<std::mutex> lock(mtx_ai);
-            shared_result = local_result;
+        publishResult(local_result, job.frame.seq());
+
+        double ms = (cv::getTickCount() - job.t_start) * 1000.0 / cv::getTickFrequency();
+        stat_ms_sum += ms;
+        if (ms > stat_ms_max) stat_ms_max = ms;
+        double e2e = (stage_record_since(STAGE_RESULT, job.frame.captureNs()) - job.frame.captureNs()) / 1e6;
+        stat_e2e_sum += e2e;
+        if (e2e > stat_e2e_max) stat_e2e_max = e2e;
+        job.frame.reset();
+
+        if (++stat_frames % AI_STATS_INTERVAL == 0) {
+            printf("[Task AI] Latency avg %.1f ms | max %.1f ms | capture->result avg %.1f ms | max %.1f ms | frames skipped %llu\n",
+                   stat_ms_sum / AI_STATS_INTERVAL, stat_ms_max,
+                   stat_e2e_sum / AI_STATS_INTERVAL, stat_e2e_max,
+                   (unsigned long long)frame_channel_overwritten(&ai_channel));
+            stat_ms_sum = stat_ms_max = 0.0;
+            stat_e2e_sum = stat_e2e_max = 0.0;
         }
-        
-        usleep(5000);
     }
     return NULL;
 }
 
+// Load Model (mỗi luồng Recognize 1 bản, cv::dnn::Net không dùng chung giữa các luồng được)
+static bool loadFaceNets(const char* path) {
+    for (int i = 0; i < AI_RECOG_THREADS; i++) {
+        try {
+            faceNets[i].loadModel(path);
+            if (!faceNets[i].isLoaded()) {
+                printf("[Task AI] CRITICAL: Model load failed!\n");
+                return false;
+            }
+        } catch (const cv::Exception& e) {
+            printf("[Task AI] Error: %s\n", e.what());
+            return false;
+        }
+    }
+    printf("[Task AI] FaceNet: %s (dim %d)\n", path, faceNets[0].getEmbeddingDim());
+    return true;
+}
+
+void* task_ai_improved(void* arg) {
+    printf("[Task AI] Loading Models...\n");
+
+    // FACENET_INT8=1: dùng model INT8 (QDQ). Gallery vẫn gắn với model FP32 gốc (cùng mạng,
+    // sai lệch đo bằng ./quant_report) nên chỉ cần số chiều embedding khớp
+    const char* int8_env = getenv("FACENET_INT8");
+    bool use_int8 = int8_env && int8_env[0] == '1';
+    if (use_int8 && !loadFaceNets(FACENET_MODEL_INT8_PATH)) {
+        printf("[Task AI] INT8 model unavailable, using %s\n", FACENET_MODEL_PATH);
+        use_int8 = false;
+    }
+    if (!use_int8 && !loadFaceNets(FACENET_MODEL_PATH)) return NULL;
+
+    // Nạp các danh tính đã đăng ký (mmap, không cần đăng ký lại sau khi khởi động lại)
+    int stored = embedding_store_open(&emb_store, EMBEDDING_STORE_PATH,
+                                      embedding_store_hash_file(FACENET_MODEL_PATH));
+    gallery.setInt8(GALLERY_INT8);
+    if (stored > 0) {
+        embedding_store_attach(&emb_store, &gallery);
+        has_owner = true;
+        printf("[Task AI] Loaded %d identities from %s\n", stored, EMBEDDING_STORE_PATH);
+    }
+
+    // Model khác số chiều với gallery -> không so sánh được
+    if (gallery.size() > 0 && faceNets[0].getEmbeddingDim() != gallery.dim()) {
+        printf("[Task AI] Model embedding dim %d != gallery dim %d\n",
+               faceNets[0].getEmbeddingDim(), gallery.dim());
+        if (!use_int8 || !loadFaceNets(FACENET_MODEL_PATH)) return NULL;
+        printf("[Task AI] INT8 model disabled, using %s\n", FACENET_MODEL_PATH);
+    }
+
+    // ENROLL_NAME=<tên>: đăng ký thêm 1 người dù đã có danh tính (đăng ký cả nhóm qua nhiều lần chạy)
+    enroll_name = getenv("ENROLL_NAME");
+    if (enroll_name && enroll_name[0]) {
+        has_owner = false;
+        printf("[Task AI] Enrolling new identity '%s'\n", enroll_name);
+    } else {
+        enroll_name = NULL;
+    }
+
+    // Bộ phát hiện khuôn mặt: FACE_DETECTOR=haar|dnn (mỗi luồng Detect 1 bản)
+    const char* detector_kind = getenv("FACE_DETECTOR");
+    if (!detector_kind || !detector_kind[0]) detector_kind = DETECTOR_DEFAULT;
+    FaceDetector* detectors[AI_DETECT_THREADS] = {};
+    for (int i = 0; i < AI_DETECT_THREADS; i++) {
+        detectors[i] = face_detector_create(detector_kind);
+        if (!detectors[i]) {
+            printf("[Task AI] Error: Cannot create detector '%s'!\n", detector_kind);
+            for (int j = 0; j < i; j++) delete detectors[j];
+            return NULL;
+        }
+    }
+    printf("[Task AI] Face detector: %s\n", detectors[0]->name());
+
+    const char* wait_mode = getenv("AI_WAIT");
+    if (!wait_mode || !wait_mode[0]) wait_mode = AI_WAIT_DEFAULT;
+    ai_wait_poll = strcmp(wait_mode, "poll") == 0;
+    printf("[Task AI] Frame wait: %s\n", ai_wait_poll ? "poll (legacy, 10 ms)" : "event");
+
+    printf("[Task AI] ===== FINAL VERSION LOADED =====\n");
+    printf("[Task AI] Using: Cosine Similarity | Augmentation | Diversity Check\n");
+    printf("[Task AI] Pipeline: %d detect thread(s) -> %d recognize thread(s)\n\n",
+           AI_DETECT_THREADS, AI_RECOG_THREADS);
+
+    face_job_queue_init(&face_jobs);
+    pthread_t t_detect[AI_DETECT_THREADS];
+    pthread_t t_recog[AI_RECOG_THREADS];
+    for (int i = 0; i < AI_RECOG_THREADS; i++) {
+        pthread_create(&t_recog[i], NULL, task_ai_recognize, &faceNets[i]);
+    }
+    for (int i = 0; i < AI_DETECT_THREADS; i++) {
+        pthread_create(&t_detect[i], NULL, task_ai_detect, detectors[i]);
+    }
+
+    // Camera đóng ai_channel -> Detect thoát -> đóng face_jobs -> Recognize xử lý nốt rồi thoát
+    for (int i = 0; i < AI_DETECT_THREADS; i++) pthread_join(t_detect[i], NULL);
+    face_job_queue_close(&face_jobs);
+    for (int i = 0; i < AI_RECOG_THREADS; i++) pthread_join(t_recog[i], NULL);
+
+    for (int i = 0; i < AI_DETECT_THREADS; i++) delete detectors[i];
+    face_job_queue_free(&face_jobs);
+    embedding_store_close(&emb_store);
+    printf("[Task AI] Stopped\n");
+    return NULL;
+}
+
+
+// Vẽ box + message của AI lên spi_buffer (RGB565) bằng overlay, frame camera giữ nguyên
+static void drawAIResult(LcdOverlay* overlay, uint8_t* fb, const AIResult& state) {
+    lcd_overlay_begin(overlay);
+    if (state.has_detection) {
+        const cv::Scalar& c = state.color;
+        uint16_t color = rgb565_be_pixel((uint8_t)c[0], (uint8_t)c[1], (uint8_t)c[2]);
+        for (size_t i = 0; i < state.faces.size(); i++) {
+            const cv::Rect& r = state.faces[i];
+            lcd_overlay_rect(overlay, fb, r.x, r.y, r.width, r.height, color, 2);
+        }
+        // Vẽ chữ
+        if (!state.faces.empty()) {
+            cv::Point p = state.faces[0].tl();
+            p.y = (p.y < 20) ? 20 : p.y - 10;
+            lcd_overlay_text(overlay, fb, state.message.c_str(), p.x, p.y, OVERLAY_FONT_MESSAGE, color);
+        }
+    } else {
+         // Hiển thị trạng thái chờ ở góc
+         lcd_overlay_text(overlay, fb, "Waiting...", 5, 20, OVERLAY_FONT_STATUS, rgb565_be_pixel(200, 200, 200));
+    }
+}
+
 // --- TASK 3: LCD DISPLAY (CONSUMER) ---
-//LCD Thread -->  lấy frame từ Queue -> vẽ UI -> convert RGB -> đẩy ra LCD SPI
+//LCD Thread -->  lấy frame từ Queue -> convert RGB565 -> vẽ UI -> đưa sang luồng gửi SPI
 //LCD sẽ lấy kết quả của AI từ đây để vẽ.
 /*Nhiệm vụ:
 ✔ Lấy frame từ queue
-✔ Vẽ bounding box + message của AI
-✔ Convert BGR → RGB565
-✔ Gửi frame qua SPI cho LCD*/
+✔ Convert BGR / YUYV → RGB565 thẳng từ frame pool vào spi_buffer trống (ping-pong), không copy / sửa frame
+✔ Vẽ bounding box + message của AI trên RGB565 (atlas glyph dựng sẵn), ghi lại tile đã vẽ
+✔ Giao buffer cho task_lcd_tx, không chờ SPI gửi xong*/
 void* task_lcd(void* arg) {
-    // Cấp phát buffer SPI 1 lần duy nhất
-    uint8_t* spi_buffer = (uint8_t*)malloc(LCD_WIDTH * LCD_HEIGHT * 2);
-    if (!spi_buffer) {
-        printf("[Task LCD] Malloc failed!\n");
+    FrameHandle handle;
+    AIResult current_ai_state;
+    LcdOverlay overlay;
+    int lcd_frames = 0;
+    uint64_t allocs_mark = 0;
+    if (!lcd_overlay_init(&overlay)) {
+        printf("[Task LCD] Overlay malloc failed!\n");
+        lcd_pipeline_stop(&lcd_pipe);
         return NULL;
     }
-
-    cv::Mat frame;
-    AIResult current_ai_state;
-    printf("[Task LCD] Started\n");
+    printf("[Task LCD] Started (RGB565 kernel: %s)\n", rgb565_kernel_name());
     
     while(1) {
         // Lấy frame từ hàng đợi (Blocking wait -> Tiết kiệm CPU khi không có ảnh)
-        queue_pop(&q_display, &frame);
-        
-        // 1. Resize nếu kích thước camera không khớp LCD
-        if (frame.cols != LCD_WIDTH || frame.rows != LCD_HEIGHT) {
-            cv::resize(frame, frame, cv::Size(LCD_WIDTH, LCD_HEIGHT));
+        if (!queue_pop(&q_display, &handle)) break;
+        stage_record_since(STAGE_WAIT_LCD, handle.publishNs());
+
+        // 1. Lấy spi_buffer trống (chỉ chờ khi cả 2 buffer đều đang chờ gửi)
+        uint32_t* dirty;
+        uint8_t* spi_buffer = lcd_pipeline_acquire(&lcd_pipe, &dirty);
+        if (!spi_buffer) break;
+
+        // 2. Chuyển sang RGB565 đọc thẳng từ frame pool (chỉ đọc, AI vẫn dùng chung được):
+        //    BGR qua kernel SIMD, YUYV 1 lượt. Xong thì trả frame về pool
+        uint64_t t_convert = frame_clock_ns();
+        if (handle.format() == FRAME_FORMAT_YUYV) {
+            yuyv_to_rgb565(handle.yuyv().data, spi_buffer, (size_t)LCD_WIDTH * LCD_HEIGHT);
+        } else {
+            const cv::Mat& frame = handle.mat();
+            if (frame.isContinuous()) {
+                bgr_to_rgb565(frame.data, spi_buffer, (size_t)frame.cols * frame.rows);
+            } else {
+                for (int i = 0; i < frame.rows; i++) {
+                    bgr_to_rgb565(frame.ptr<uint8_t>(i), spi_buffer + i * frame.cols * 2, frame.cols);
+                }
+            }
         }
+        handle.reset();
+        uint64_t t_overlay = stage_record_since(STAGE_RGB565, t_convert);
 
-        // 2. Lấy thông tin AI mới nhất
+        // 3. Lấy thông tin AI mới nhất
         {
             std::lock_guard<std::mutex> lock(mtx_ai);
             current_ai_state = shared_result;
         }
 
-        // 3. Vẽ UI lên ảnh (Vẽ TRƯỚC khi convert màu)
-        if (current_ai_state.has_detection) {
-            for (size_t i = 0; i < current_ai_state.faces.size(); i++) {
-                cv::rectangle(frame, current_ai_state.faces[i], current_ai_state.color, 2);
-            }
-            // Vẽ chữ
-            if (!current_ai_state.faces.empty()) {
-                cv::Point p = current_ai_state.faces[0].tl();
-                p.y = (p.y < 20) ? 20 : p.y - 10;
-                cv::putText(frame, current_ai_state.message, p, 
-                            cv::FONT_HERSHEY_SIMPLEX, 0.6, current_ai_state.color, 2);
-            }
-        } else {
-             // Hiển thị trạng thái chờ ở góc
-             cv::putText(frame, "Waiting...", cv::Point(5, 20), 
-                        cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(200, 200, 200), 1);
-        }
-
-        // 4. Chuyển đổi BGR sang RGB565 (Tối ưu hóa vòng lặp)
-        int idx = 0;
-        uint8_t* data = frame.data;
-        int channels = frame.channels(); // 3
-        int width = frame.cols;
-        int height = frame.rows;
-
-        for (int i = 0; i < height; i++) {
-            // Tối ưu hóa: Tính index dòng trước
-            int row_offset = i * width * channels;
-            
-            for (int j = 0; j < width; j++) {
-                int pixel_idx = row_offset + (j * channels);
-                
-                uint8_t b = data[pixel_idx + 0];
-                uint8_t g = data[pixel_idx + 1];
-                uint8_t r = data[pixel_idx + 2];
-                
-                // RGB565 conversion
-                uint16_t c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-                
-                // Big Endian cho SPI
-                spi_buffer[idx++] = (c >> 8) & 0xFF;
-                spi_buffer[idx++] = c & 0xFF;
-            }
+        // 4. Vẽ UI lên RGB565; tile vẽ ở frame này / frame trước luôn được LCD delta gửi
+        drawAIResult(&overlay, spi_buffer, current_ai_state);
+        lcd_overlay_dirty(&overlay, dirty);
+        stage_record_since(STAGE_OVERLAY, t_overlay);
+
+        // 5. Giao cho luồng gửi SPI
+        lcd_pipeline_submit(&lcd_pipe);
+
+        if (++lcd_frames % LCD_STATS_INTERVAL == 0) {
+            uint64_t allocs = alloc_trace_thread_count();
+            printf("[Task LCD] Queue: pushed %llu | dropped %llu | heap allocs/frame: %.2f\n",
+                   (unsigned long long)queue_pushed(&q_display),
+                   (unsigned long long)queue_dropped(&q_display),
+                   (double)(allocs - allocs_mark) / LCD_STATS_INTERVAL);
+            allocs_mark = allocs;
         }
-        
-        // 5. Gửi ra LCD qua SPI
-        bcm2835_gpio_write(PIN_DC, LOW); // Command mode
-        lcd_set_window(0, 0, LCD_WIDTH-1, LCD_HEIGHT-1); 
-        
-        bcm2835_gpio_write(PIN_DC, HIGH); // Data mode
-        bcm2835_spi_transfern((char*)spi_buffer, LCD_WIDTH * LCD_HEIGHT * 2);
     }
-    
-    free(spi_buffer);
+
+    // Hết frame -> dừng luồng gửi SPI
+    lcd_pipeline_stop(&lcd_pipe);
+    lcd_overlay_free(&overlay);
     return NULL;
 }
 
+// --- TASK 4: LCD TRANSMIT ---
+// Gửi spi_buffer đã convert ra LCD qua transport hiện tại,
+// chạy song song với việc convert frame kế tiếp trong task_lcd.
+static uint64_t thread_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
 
+void* task_lcd_tx(void* arg) {
+    LcdTransport* t = lcd_get_transport();
+    printf("[Task LCD TX] Started (transport: %s)\n", t->name);
 
-    
+    int lcd_frames = 0;
+    // CPU luồng gửi bận / thời gian gửi / byte ra SPI mỗi LCD_STATS_INTERVAL frame:
+    // bcm2835 polling thì CPU ~ wall, spidev (DMA) thì CPU nhỏ hơn nhiều
+    uint64_t stat_cpu_ns = 0, stat_wall_ns = 0;
+    uint64_t bytes_mark = t->bytes, writes_mark = t->writes;
+    while(1) {
+        const uint32_t* dirty;
+        const uint8_t* spi_buffer = lcd_pipeline_next(&lcd_pipe, &dirty);
+        if (!spi_buffer) break;
+        uint64_t t_send = frame_clock_ns();
+        uint64_t cpu_send = thread_cpu_ns();
+
+#if LCD_DELTA_UPDATE
+        // Chỉ gửi các tile thay đổi so với frame trước (+ tile overlay đã vẽ)
+        lcd_delta_send(&lcd_pipe.delta, spi_buffer, dirty);
+        if (++lcd_frames % LCD_STATS_INTERVAL == 0) {
+            lcd_delta_print_stats(&lcd_pipe.delta);
+        }
+#else
+        lcd_push_region(0, 0, LCD_WIDTH-1, LCD_HEIGHT-1, spi_buffer, LCD_FRAME_BYTES);
+        lcd_frames++;
+#endif
+        stat_cpu_ns += thread_cpu_ns() - cpu_send;
+        stat_wall_ns += stage_record_since(STAGE_SPI, t_send) - t_send;
+
+        lcd_pipeline_release(&lcd_pipe);
+
+        if (lcd_frames % LCD_STATS_INTERVAL == 0) {
+            uint64_t bytes = t->bytes - bytes_mark;
+            printf("[Task LCD TX] %s: cpu %.2f ms/frame | send %.2f ms/frame | %.2f MB/s | %.1f KB, %.0f writes/frame\n",
+                   t->name, stat_cpu_ns / 1e6 / LCD_STATS_INTERVAL, stat_wall_ns / 1e6 / LCD_STATS_INTERVAL,
+                   stat_wall_ns ? bytes * 1e3 / stat_wall_ns : 0.0,
+                   bytes / 1024.0 / LCD_STATS_INTERVAL, (double)(t->writes - writes_mark) / LCD_STATS_INTERVAL);
+            stat_cpu_ns = stat_wall_ns = 0;
+            bytes_mark = t->bytes;
+            writes_mark = t->writes;
+        }
+    }
+    return NULL;
+}
 
+// --- TASK 5: STATS ---
+// Dump histogram các stage mỗi STATS_INTERVAL_S giây vào STATS_FILE (nếu có) và khi nhận SIGUSR1
+void* task_stats(void* arg) {
+    const char* path = getenv("STATS_FILE");
+    FILE* f = NULL;
+    if (path && path[0]) {
+        f = fopen(path, "a");
+        if (!f) printf("[Task Stats] Cannot open %s\n", path);
+    }
+
+    uint64_t next_dump = frame_clock_ns() + STATS_INTERVAL_S * 1000000000ULL;
+    while (app_running) {
+        usleep(100000);
+        uint64_t now = frame_clock_ns();
+        if (stats_dump_requested || (f && now >= next_dump)) {
+            stats_dump_requested = 0;
+            stage_stats_dump(f ? f : stdout);
+            next_dump = now + STATS_INTERVAL_S * 1000000000ULL;
+        }
+    }
+    if (f) fclose(f);
+    return NULL;
+}
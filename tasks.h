@@ -1,8 +1,17 @@
 #ifndef TASKS_H
 #define TASKS_H
 
+#include <signal.h>
+
+// 0 = đang dừng (Ctrl+C / SIGTERM): Camera thoát vòng lặp và đóng các kênh phía sau
+extern volatile sig_atomic_t app_running;
+// 1 = có SIGUSR1, task_stats dump thống kê stage rồi xóa cờ
+extern volatile sig_atomic_t stats_dump_requested;
+
 void* task_camera(void* arg);
 void* task_ai_improved(void* arg);
 void* task_lcd(void* arg);
+void* task_lcd_tx(void* arg);
+void* task_stats(void* arg);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,607 @@
+// Kiểm tra tính đúng của các thành phần pipeline, không cần Pi / LCD / camera / model.
+//   make test
+//   ./unittest [lọc theo tên]
+// Mỗi case in 1 dòng OK / FAIL, exit code khác 0 nếu có case lỗi (dùng được trong CI).
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#include <algorithm>
+#include <vector>
+#include "config.h"
+#include "rgb565.h"
+#include "alloc_trace.h"
+#include "frame_pool.h"
+#include "queue_helper.h"
+#include "frame_channel.h"
+#include "facenet.h"
+#include "face_preprocess.h"
+#include "face_quality.h"
+#include "lcd_driver.h"
+#include "lcd_pipeline.h"
+#include "lcd_overlay.h"
+#include "v4l2_capture.h"
+
+static const char* filter = NULL;
+static int failed_cases = 0;
+static int case_errors;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        if (case_errors++ < 5) { printf("    %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } \
+    } \
+} while (0)
+
+template <typename F>
+static void run(const char* name, F fn) {
+    if (filter && !strstr(name, filter)) return;
+    case_errors = 0;
+    fn();
+    printf("[%s] %s", case_errors ? "FAIL" : " OK ", name);
+    if (case_errors) printf(" (%d errors)", case_errors);
+    printf("\n");
+    fflush(stdout);
+    if (case_errors) failed_cases++;
+}
+
+// xorshift32: dữ liệu ngẫu nhiên lặp lại được giữa các lần chạy
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng_next() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void fill_random(uint8_t* p, size_t n) {
+    for (size_t i = 0; i < n; i++) p[i] = (uint8_t)rng_next();
+}
+
+// --- BGR -> RGB565: mọi kernel CPU chạy được phải giống bản scalar từng bit ---
+// Độ dài lẻ (đuôi không đủ 1 vector) + địa chỉ nguồn / đích không căn lề.
+// So cả vùng đệm quanh output để bắt kernel ghi tràn.
+static void test_rgb565_kernels() {
+    Rgb565Kernel kernels[8];
+    int nk = rgb565_supported_kernels(kernels, 8);
+    CHECK(nk >= 1 && strcmp(kernels[nk - 1].name, "scalar") == 0, "scalar kernel must be last");
+    CHECK(strcmp(kernels[0].name, rgb565_kernel_name()) == 0, "dispatch uses %s, expected %s",
+          rgb565_kernel_name(), kernels[0].name);
+
+    const size_t lengths[] = { 0, 1, 2, 7, 15, 16, 17, 31, 32, 33, 47, 63, 65, 101, 255,
+                               LCD_WIDTH, LCD_WIDTH * LCD_HEIGHT + 7 };
+    const size_t pad = 64;
+    for (size_t len : lengths) {
+        std::vector<uint8_t> src(len * 3 + pad);
+        std::vector<uint8_t> ref(len * 2 + pad), out(len * 2 + pad);
+        fill_random(src.data(), src.size());
+
+        for (size_t src_off = 0; src_off < 4; src_off++) {
+            for (size_t dst_off = 0; dst_off < 2; dst_off++) {
+                memset(ref.data(), 0xA5, ref.size());
+                bgr_to_rgb565_scalar(src.data() + src_off, ref.data() + dst_off, len);
+
+                for (int k = 0; k < nk; k++) {
+                    memset(out.data(), 0xA5, out.size());
+                    kernels[k].fn(src.data() + src_off, out.data() + dst_off, len);
+                    CHECK(memcmp(out.data(), ref.data(), out.size()) == 0,
+                          "%s differs from scalar (pixels %zu, src +%zu, dst +%zu)",
+                          kernels[k].name, len, src_off, dst_off);
+                }
+            }
+        }
+    }
+    printf("    kernels:");
+    for (int k = 0; k < nk; k++) printf(" %s", kernels[k].name);
+    printf("\n");
+}
+
+// --- YUYV -> RGB565 1 lượt: giống cvtColor(COLOR_YUV2BGR_YUYV) + bgr_to_rgb565 từng bit ---
+// Số pixel lẻ: pixel cuối vẫn được ghi (V = 128), không ghi tràn
+static void test_yuyv_rgb565() {
+    const int sizes[][2] = { { 2, 1 }, { 16, 3 }, { LCD_WIDTH, LCD_HEIGHT } };
+    for (const auto& sz : sizes) {
+        int w = sz[0], h = sz[1];
+        cv::Mat yuyv(h, w, CV_8UC2), bgr;
+        fill_random(yuyv.data, yuyv.total() * 2);
+        cv::cvtColor(yuyv, bgr, cv::COLOR_YUV2BGR_YUYV);
+
+        std::vector<uint8_t> ref(yuyv.total() * 2), out(yuyv.total() * 2);
+        bgr_to_rgb565_scalar(bgr.data, ref.data(), bgr.total());
+        yuyv_to_rgb565(yuyv.data, out.data(), yuyv.total());
+        CHECK(memcmp(out.data(), ref.data(), ref.size()) == 0, "%dx%d differs from cvtColor + bgr_to_rgb565", w, h);
+    }
+
+    uint8_t src[14], tail[4], even[16], out[16];
+    fill_random(src, sizeof(src));
+    yuyv_to_rgb565(src, even, 6);
+    memset(out, 0xA5, sizeof(out));
+    yuyv_to_rgb565(src, out, 7);
+    const uint8_t last[4] = { src[12], src[13], src[12], 128 };
+    yuyv_to_rgb565(last, tail, 2);
+    CHECK(memcmp(out, even, 12) == 0, "odd length changed the even prefix");
+    CHECK(memcmp(out + 12, tail, 2) == 0, "odd tail pixel not converted");
+    CHECK(out[14] == 0xA5 && out[15] == 0xA5, "odd length wrote past the end");
+}
+
+// --- V4L2 thiết bị giả: file YUYV thô -> đúng từng frame, hết file trả 0, rewind về frame đầu ---
+// Phần dư không đủ 1 frame ở cuối file bị bỏ qua
+static void test_v4l2_fake_yuyv() {
+    const int w = 16, h = 4, frames = 3;
+    const size_t frame_bytes = (size_t)w * h * 2;
+    std::vector<uint8_t> data(frame_bytes * frames + 5);
+    fill_random(data.data(), data.size());
+
+    char path[] = "/tmp/unittest_yuyv_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0, "mkstemp failed");
+    if (fd < 0) return;
+    CHECK(write(fd, data.data(), data.size()) == (ssize_t)data.size(), "write failed");
+    close(fd);
+
+    V4l2Capture cap;
+    int opened = v4l2_capture_open(&cap, path, w, h, 30, V4L2_PIX_FMT_YUYV);
+    CHECK(opened && cap.fake && cap.width == w && cap.height == h, "open failed");
+    if (opened) {
+        const uint8_t* frame = NULL;
+        size_t size = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < frames; i++) {
+                int r = v4l2_capture_next(&cap, &frame, &size, 0);
+                CHECK(r == 1 && size == frame_bytes, "pass %d frame %d: next %d, size %zu", pass, i, r, size);
+                if (r == 1) {
+                    CHECK(memcmp(frame, data.data() + i * frame_bytes, frame_bytes) == 0,
+                          "pass %d frame %d: content differs from file", pass, i);
+                }
+            }
+            CHECK(v4l2_capture_next(&cap, &frame, &size, 0) == 0, "pass %d: frame after end of file", pass);
+            v4l2_capture_rewind(&cap);
+        }
+        v4l2_capture_close(&cap);
+    }
+    unlink(path);
+}
+
+// --- LCD: frame đi qua lcd_pipeline + lcd_delta tới ILI9341 giả lập ---
+// Sau mỗi frame, framebuffer của mock phải đúng bằng nội dung delta nghĩ LCD đang hiện (prev);
+// vùng đổi vượt ngưỡng và tile bị ép (force) phải tới LCD nguyên vẹn.
+static void fill_rect(uint8_t* frame, int x, int y, int w, int h) {
+    for (int r = y; r < y + h; r++) fill_random(frame + (r * LCD_WIDTH + x) * 2, w * 2);
+}
+
+static void test_lcd_pipeline_mock() {
+    LcdMock mock;
+    LcdDelta delta;
+    LcdPipeline pipe;
+    CHECK(lcd_mock_init(&mock) && lcd_delta_init(&delta) && lcd_pipeline_init(&pipe), "init failed");
+    LcdTransport t = lcd_transport_mock(&mock);
+    LcdTransport* saved = lcd_get_transport();
+    lcd_set_transport(&t);
+
+    std::vector<uint8_t> src(LCD_FRAME_BYTES);
+    fill_random(src.data(), src.size());
+
+    // Mỗi bước: 1 vùng random {x, y, w, h, gửi}, kể cả mép phải / dưới và vùng lệch lưới tile.
+    // gửi = 0: 1 pixel lẻ, dưới ngưỡng -> LCD phải giữ nội dung cũ
+    const int regions[][5] = {
+        { 0, 0, 0, 0, 1 },                                  // Frame đầu: gửi full
+        { 5, 3, 40, 20, 1 },
+        { LCD_WIDTH - 17, LCD_HEIGHT - 9, 17, 9, 1 },
+        { 100, 50, 1, 1, 0 },
+        { 33, 17, 62, 30, 1 },
+        { 0, 0, LCD_WIDTH, LCD_HEIGHT, 1 },
+    };
+    const int steps = (int)(sizeof(regions) / sizeof(regions[0]));
+
+    for (int i = 0; i < steps + 1; i++) {
+        uint32_t force_tx = 3, force_ty = 7;
+        uint32_t* dirty = NULL;
+        uint8_t* buf = lcd_pipeline_acquire(&pipe, &dirty);
+        CHECK(buf && dirty, "acquire failed");
+        if (!buf || !dirty) break;
+
+        memset(dirty, 0, sizeof(uint32_t) * LCD_TILES_Y);
+        if (i < steps) {
+            fill_rect(src.data(), regions[i][0], regions[i][1], regions[i][2], regions[i][3]);
+        } else {
+            // Bước cuối: đổi 1 bit trong 1 tile (dưới ngưỡng) nhưng tile bị ép gửi như overlay
+            src[((force_ty * LCD_TILE_H + 2) * LCD_WIDTH + force_tx * LCD_TILE_W + 4) * 2 + 1] ^= 1;
+            dirty[force_ty] = 1u << force_tx;
+        }
+        memcpy(buf, src.data(), LCD_FRAME_BYTES);
+        lcd_pipeline_submit(&pipe);
+
+        const uint32_t* force = NULL;
+        const uint8_t* out = lcd_pipeline_next(&pipe, &force);
+        CHECK(out == buf && force == dirty, "pipeline returned a different buffer");
+        lcd_delta_send(&delta, out, force);
+        lcd_pipeline_release(&pipe);
+
+        CHECK(memcmp(mock.fb, delta.prev, LCD_FRAME_BYTES) == 0, "step %d: mock LCD differs from delta prev", i);
+        int sent = i >= steps || regions[i][4];
+        CHECK((memcmp(mock.fb, src.data(), LCD_FRAME_BYTES) == 0) == sent,
+              sent ? "step %d: mock LCD differs from source" : "step %d: change below threshold was sent", i);
+        if (!sent) memcpy(src.data(), delta.prev, LCD_FRAME_BYTES);
+    }
+
+    // Buffer rỗng (len 0) không được làm mock đọc ngoài vùng nhớ
+    uint64_t writes = mock.writes;
+    lcd_transport_write(&t, LOW, NULL, 0);
+    lcd_transport_write(&t, HIGH, NULL, 0);
+    CHECK(mock.writes == writes, "empty write counted");
+
+    lcd_set_transport(saved);
+    lcd_pipeline_free(&pipe);
+    lcd_delta_free(&delta);
+    lcd_mock_free(&mock);
+}
+
+// --- Overlay vẽ thẳng lên spi_buffer: box + chữ tràn ra ngoài màn hình ---
+// Chỉ pixel trong màn hình và trong hộp bao của từng hình bị đổi (không ghi tràn / quấn sang dòng khác);
+// tile đã vẽ nằm trong lcd_overlay_dirty ở frame đó và frame sau; khi overlay biến mất,
+// delta (ép gửi tile dirty) phải trả LCD giả lập về đúng frame camera.
+struct OverlayBox {
+    int x0, y0, x1, y1;         // Hộp bao [x0, x1) x [y0, y1) trước khi cắt theo màn hình
+};
+
+static bool in_boxes(const OverlayBox* boxes, int n, int x, int y) {
+    for (int i = 0; i < n; i++) {
+        if (x >= boxes[i].x0 && x < boxes[i].x1 && y >= boxes[i].y0 && y < boxes[i].y1) return true;
+    }
+    return false;
+}
+
+static OverlayBox text_box(const LcdOverlay& o, const char* text, int x, int baseline, OverlayFontId font) {
+    const OverlayFont& f = o.fonts[font];
+    int pen = x;
+    for (const char* c = text; *c; c++) pen += f.advance[*c - OVERLAY_FIRST_CHAR];
+    OverlayBox b = { x - f.origin_x, baseline - f.origin_y, pen - f.origin_x + f.cell_w, baseline - f.origin_y + f.cell_h };
+    return b;
+}
+
+static void test_overlay_offscreen() {
+    LcdOverlay overlay;
+    LcdMock mock;
+    LcdDelta delta;
+    CHECK(lcd_overlay_init(&overlay) && lcd_mock_init(&mock) && lcd_delta_init(&delta), "init failed");
+    LcdTransport t = lcd_transport_mock(&mock);
+    LcdTransport* saved = lcd_get_transport();
+    lcd_set_transport(&t);
+
+    // spi_buffer có vùng canh 2 đầu để bắt ghi ra ngoài
+    const size_t guard = 4096;
+    std::vector<uint8_t> canvas(LCD_FRAME_BYTES + 2 * guard, 0x5A);
+    uint8_t* fb = canvas.data() + guard;
+    std::vector<uint8_t> cam(LCD_FRAME_BYTES);
+    const uint16_t bg = rgb565_be_pixel(40, 80, 120), color = rgb565_be_pixel(0, 255, 0);
+    for (int i = 0; i < LCD_WIDTH * LCD_HEIGHT; i++) memcpy(cam.data() + i * 2, &bg, 2);
+
+    const char* msg = "ACCESS GRANTED: overflow";
+    const char* status = "Waiting...";
+    const int W = LCD_WIDTH, H = LCD_HEIGHT;
+    OverlayBox boxes[] = {
+        { -10 - 1, -6 - 1, -10 + 60 - 1 + 1, -6 + 40 - 1 + 1 },     // Box thò ra trên / trái, nét 2
+        { W - 20 - 1, H - 15 - 1, W - 20 + 50 - 1 + 2, H - 15 + 40 - 1 + 2 },  // Box thò ra dưới / phải, nét 3
+        text_box(overlay, msg, W - 60, H - 4, OVERLAY_FONT_MESSAGE),
+        text_box(overlay, status, -25, 6, OVERLAY_FONT_STATUS),
+    };
+    const int n_boxes = (int)(sizeof(boxes) / sizeof(boxes[0]));
+
+    uint32_t dirty[LCD_TILES_Y], first[LCD_TILES_Y];
+    for (int frame = 0; frame < 4; frame++) {
+        // frame 0: chưa có UI, 1: vẽ UI, 2: UI biến mất (vẫn gửi lại tile cũ), 3: không còn gì phải ép
+        memcpy(fb, cam.data(), LCD_FRAME_BYTES);
+        lcd_overlay_begin(&overlay);
+        if (frame == 1) {
+            lcd_overlay_rect(&overlay, fb, -10, -6, 60, 40, color, 2);
+            lcd_overlay_rect(&overlay, fb, W - 20, H - 15, 50, 40, color, 3);
+            lcd_overlay_text(&overlay, fb, msg, W - 60, H - 4, OVERLAY_FONT_MESSAGE, color);
+            lcd_overlay_text(&overlay, fb, status, -25, 6, OVERLAY_FONT_STATUS, color);
+        }
+        lcd_overlay_dirty(&overlay, dirty);
+
+        if (frame == 1) {
+            uint32_t changed[LCD_TILES_Y] = { 0 };
+            int n_changed = 0, stray = 0;
+            for (int y = 0; y < H; y++) {
+                for (int x = 0; x < W; x++) {
+                    if (memcmp(fb + (y * W + x) * 2, cam.data() + (y * W + x) * 2, 2) == 0) continue;
+                    n_changed++;
+                    changed[y / LCD_TILE_H] |= 1u << (x / LCD_TILE_W);
+                    stray += !in_boxes(boxes, n_boxes, x, y) || memcmp(fb + (y * W + x) * 2, &color, 2) != 0;
+                }
+            }
+            CHECK(n_changed > 0, "nothing drawn");
+            CHECK(stray == 0, "%d pixels changed outside the drawn shapes", stray);
+            // Góc nhìn thấy của 2 box phải có nét
+            CHECK(memcmp(fb + ((40 - 6 - 1) * W + 0) * 2, &color, 2) == 0, "top-left box bottom edge missing");
+            CHECK(memcmp(fb + ((H - 15) * W + W - 20) * 2, &color, 2) == 0, "bottom-right box corner missing");
+            for (int ty = 0; ty < LCD_TILES_Y; ty++) {
+                CHECK((dirty[ty] & changed[ty]) == changed[ty], "tile row %d: drawn tiles %08x not dirty (%08x)",
+                      ty, changed[ty], dirty[ty]);
+            }
+            memcpy(first, dirty, sizeof(first));
+        }
+        for (size_t i = 0; i < guard; i++) {
+            if (canvas[i] != 0x5A || canvas[guard + LCD_FRAME_BYTES + i] != 0x5A) {
+                CHECK(false, "frame %d: write outside the framebuffer", frame);
+                break;
+            }
+        }
+        for (int ty = 0; ty < LCD_TILES_Y; ty++) {
+            uint32_t expect = frame == 1 || frame == 2 ? first[ty] : 0;
+            CHECK(dirty[ty] == expect, "frame %d tile row %d: dirty %08x, expected %08x", frame, ty, dirty[ty], expect);
+            CHECK((dirty[ty] >> LCD_TILES_X) == 0, "frame %d tile row %d: dirty bit past the last tile", frame, ty);
+        }
+
+        lcd_delta_send(&delta, fb, dirty);
+        CHECK(memcmp(mock.fb, fb, LCD_FRAME_BYTES) == 0, "frame %d: mock LCD differs from the framebuffer", frame);
+    }
+    CHECK(memcmp(mock.fb, cam.data(), LCD_FRAME_BYTES) == 0, "overlay left on the LCD after it disappeared");
+
+    lcd_set_transport(saved);
+    lcd_delta_free(&delta);
+    lcd_mock_free(&mock);
+    lcd_overlay_free(&overlay);
+}
+
+// --- Số lần ghi transport của các lệnh LCD (mỗi lần ghi = 1 giao dịch SPI) ---
+// Cửa sổ: 0x2A | 4 byte | 0x2B | 4 byte | 0x2C = 5 lần ghi; vùng ảnh thêm 1 lần ghi pixel.
+// Init: 20 lệnh + 16 khối tham số, 0x28 liền 0xCF chung 1 lần ghi (cùng DC) = 35 lần, 58 byte tham số
+struct LcdCounts {
+    uint64_t writes, cmd_bytes, data_bytes;
+};
+
+static LcdCounts lcd_counts(const LcdMock& m) {
+    LcdCounts c = { m.writes, m.cmd_bytes, m.data_bytes };
+    return c;
+}
+
+static void check_counts(const char* what, const LcdMock& m, const LcdCounts& before,
+                         uint64_t writes, uint64_t cmd_bytes, uint64_t data_bytes) {
+    LcdCounts now = lcd_counts(m);
+    CHECK(now.writes - before.writes == writes && now.cmd_bytes - before.cmd_bytes == cmd_bytes &&
+          now.data_bytes - before.data_bytes == data_bytes,
+          "%s: %llu writes, cmd %llu B, data %llu B (expected %llu, %llu, %llu)", what,
+          (unsigned long long)(now.writes - before.writes), (unsigned long long)(now.cmd_bytes - before.cmd_bytes),
+          (unsigned long long)(now.data_bytes - before.data_bytes), (unsigned long long)writes,
+          (unsigned long long)cmd_bytes, (unsigned long long)data_bytes);
+}
+
+static void test_lcd_command_writes() {
+    LcdMock mock;
+    CHECK(lcd_mock_init(&mock), "init failed");
+    LcdTransport t = lcd_transport_mock(&mock);
+    LcdTransport* saved = lcd_get_transport();
+    lcd_set_transport(&t);
+
+    LcdCounts c = lcd_counts(mock);
+    lcd_set_window(0, 0, LCD_WIDTH - 1, LCD_HEIGHT - 1);
+    check_counts("lcd_set_window", mock, c, 5, 3, 8);
+
+    // 4x2 pixel tại (10, 20): framebuffer mock phải nhận đúng vùng đó
+    uint8_t px[4 * 2 * 2];
+    fill_random(px, sizeof(px));
+    c = lcd_counts(mock);
+    lcd_push_region(10, 20, 13, 21, px, sizeof(px));
+    check_counts("lcd_push_region", mock, c, 6, 3, 8 + sizeof(px));
+    for (int r = 0; r < 2; r++) {
+        CHECK(memcmp(mock.fb + ((20 + r) * LCD_WIDTH + 10) * 2, px + r * 8, 8) == 0, "region row %d differs", r);
+    }
+
+    c = lcd_counts(mock);
+    lcd_init_full();
+    check_counts("lcd_init_full", mock, c, 35, 20, 58);
+
+    // Khối tham số dài hơn buffer stream: phần đã gom gửi trước, rồi lệnh + tham số gửi thẳng
+    uint8_t big[LCD_CMD_STREAM_MAX + 36];
+    fill_random(big, sizeof(big));
+    LcdCmdStream s;
+    s.len = 0;
+    c = lcd_counts(mock);
+    lcd_stream_cmd(&s, 0x26, big, 1);
+    lcd_stream_cmd(&s, 0xE0, big, sizeof(big));
+    CHECK(s.len == 0, "oversize command left %u bytes in the stream", s.len);
+    check_counts("oversize command", mock, c, 4, 2, 1 + sizeof(big));
+    lcd_stream_flush(&s);
+
+    lcd_set_transport(saved);
+    lcd_mock_free(&mock);
+}
+
+// --- Không malloc mỗi frame: Camera -> pool -> queue (LCD) + channel (AI) sau khi đã chạy ấm ---
+// Mỗi luồng đếm cấp phát của chính nó (alloc_trace, test luôn build với ALLOC_TRACE)
+#define ALLOC_WARMUP_FRAMES 50
+#define ALLOC_TEST_FRAMES   2000
+
+static FramePool alloc_pool;
+static FrameQueue alloc_queue;
+static FrameChannel alloc_channel;
+
+struct AllocConsumer {
+    uint64_t frames;
+    uint64_t mark;              // Số cấp phát lúc nhận frame đầu tiên sau warm-up (UINT64_MAX = chưa tới)
+    uint64_t allocs;            // Số cấp phát sau warm-up
+    uint32_t checksum;
+};
+
+static void consume_frame(AllocConsumer* c, const FrameHandle& f) {
+    if (c->mark == UINT64_MAX && f.seq() >= ALLOC_WARMUP_FRAMES) c->mark = alloc_trace_thread_count();
+    c->frames++;
+    c->checksum += f.mat().data[f.seq() % LCD_WIDTH];
+}
+
+static void finish_consumer(AllocConsumer* c) {
+    c->allocs = c->mark == UINT64_MAX ? 0 : alloc_trace_thread_count() - c->mark;
+}
+
+static void* alloc_lcd_consumer(void* arg) {
+    AllocConsumer* c = (AllocConsumer*)arg;
+    FrameHandle f;
+    while (queue_pop(&alloc_queue, &f)) {
+        consume_frame(c, f);
+        f.reset();
+    }
+    finish_consumer(c);
+    return NULL;
+}
+
+static void* alloc_ai_consumer(void* arg) {
+    AllocConsumer* c = (AllocConsumer*)arg;
+    FrameHandle f;
+    while (frame_channel_wait(&alloc_channel, &f)) {
+        consume_frame(c, f);
+        f.reset();
+    }
+    finish_consumer(c);
+    return NULL;
+}
+
+static void test_alloc_per_frame() {
+#ifndef ALLOC_TRACE
+    CHECK(0, "build with -DALLOC_TRACE (make test does)");
+    return;
+#endif
+    frame_pool_init(&alloc_pool);
+    queue_init(&alloc_queue);
+    frame_channel_init(&alloc_channel);
+
+    AllocConsumer lcd = { 0, UINT64_MAX, 0, 0 }, ai = { 0, UINT64_MAX, 0, 0 };
+    pthread_t t_lcd, t_ai;
+    pthread_create(&t_lcd, NULL, alloc_lcd_consumer, &lcd);
+    pthread_create(&t_ai, NULL, alloc_ai_consumer, &ai);
+
+    uint64_t mark = 0, exhausted = 0;
+    for (uint64_t seq = 0; seq < ALLOC_WARMUP_FRAMES + ALLOC_TEST_FRAMES; seq++) {
+        if (seq == ALLOC_WARMUP_FRAMES) mark = alloc_trace_thread_count();
+
+        FrameHandle frame = frame_pool_acquire(&alloc_pool);
+        if (frame.empty()) {
+            exhausted++;
+            continue;
+        }
+        frame.setFormat(FRAME_FORMAT_BGR);
+        frame.setSeq(seq);
+        frame.setCaptureNs(frame_clock_ns());
+        memset(frame.mat().data, (int)seq, frame.mat().total() * frame.mat().elemSize());
+        frame.setPublishNs(frame_clock_ns());
+        queue_push(&alloc_queue, frame);
+        frame_channel_publish(&alloc_channel, frame);
+    }
+    uint64_t producer_allocs = alloc_trace_thread_count() - mark;
+
+    queue_close(&alloc_queue);
+    frame_channel_close(&alloc_channel);
+    pthread_join(t_lcd, NULL);
+    pthread_join(t_ai, NULL);
+
+    CHECK(producer_allocs == 0, "camera thread: %llu allocs in %d frames",
+          (unsigned long long)producer_allocs, ALLOC_TEST_FRAMES);
+    CHECK(lcd.allocs == 0, "LCD consumer: %llu allocs", (unsigned long long)lcd.allocs);
+    CHECK(ai.allocs == 0, "AI consumer: %llu allocs", (unsigned long long)ai.allocs);
+    CHECK(lcd.frames > 0 && ai.frames > 0, "consumers got no frames");
+    CHECK(frame_pool_available(&alloc_pool) == FRAME_POOL_SIZE, "pool leaked %d frames",
+          FRAME_POOL_SIZE - frame_pool_available(&alloc_pool));
+    printf("    frames: LCD %llu, AI %llu, pool exhausted %llu\n", (unsigned long long)lcd.frames,
+           (unsigned long long)ai.frames, (unsigned long long)exhausted);
+    frame_channel_free(&alloc_channel);
+}
+
+// --- Tiền xử lý FaceNet: kernel gộp 1 lượt phải cho cùng blob với preprocessFaceStandard + blobFromImage ---
+// ROI cắt từ frame lớn hơn (stride > width * 3) hoặc liền nhau, nhiều kích thước, kể cả đúng 2x và 1x.
+// x86 khớp tuyệt đối; HAL của OpenCV trên ARM có thể lệch 1 mức 8 bit (1/128)
+#if defined(__arm__) || defined(__aarch64__)
+#define PREPROCESS_TOL (1.0f / 128 + 1e-6f)
+#else
+#define PREPROCESS_TOL 1e-6f
+#endif
+
+static void test_preprocess_fused() {
+    const int N = FACE_INPUT_SIZE;
+    cv::RNG rng(1234);
+    cv::Mat frame(320, 400, CV_8UC3);
+    rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+
+    std::vector<cv::Size> sizes = { cv::Size(2 * N, 2 * N), cv::Size(N, N), cv::Size(100, 100),
+                                    cv::Size(57, 91), cv::Size(150, 130), cv::Size(300, 260),
+                                    cv::Size(40, 40), cv::Size(61, 47), cv::Size(113, 111) };
+    for (int i = 0; i < 24; i++) sizes.push_back(cv::Size(rng.uniform(30, 301), rng.uniform(30, 301)));
+
+    std::vector<float> out(3 * N * N);
+    float worst = 0.0f;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        cv::Size sz = sizes[i];
+        cv::Rect r(rng.uniform(0, frame.cols - sz.width + 1), rng.uniform(0, frame.rows - sz.height + 1),
+                   sz.width, sz.height);
+        cv::Mat roi = frame(r);
+        if (i % 2) roi = roi.clone();       // Xen kẽ ROI liền nhau (stride = width * 3)
+
+        cv::Mat ref = cv::dnn::blobFromImage(FaceNet::preprocessFaceStandard(roi));
+        face_preprocess_fused(roi.data, roi.cols, roi.rows, roi.step, out.data());
+
+        const float* pr = ref.ptr<float>();
+        float max_diff = 0.0f;
+        for (size_t k = 0; k < out.size(); k++) max_diff = std::max(max_diff, fabsf(out[k] - pr[k]));
+        worst = std::max(worst, max_diff);
+        CHECK(ref.total() == out.size() && max_diff <= PREPROCESS_TOL, "%dx%d (stride %zu): max |diff| %g",
+              sz.width, sz.height, (size_t)roi.step, max_diff);
+    }
+    printf("    %zu ROIs, max |diff| %g\n", sizes.size(), worst);
+}
+
+// --- Điểm chất lượng: 1 lượt trên ảnh xám phải bằng FaceNet::assessFaceQuality ---
+// ROI cắt từ frame lớn (pixel ngay ngoài ROI khác giá trị reflect101 -> bắt kernel đọc lấn ra ngoài ROI).
+// Nhiễu biên độ < 10 để phương sai Laplacian (~20 * var nhiễu) dưới ngưỡng bão hòa 400,
+// độ sáng / tương phản đổi theo từng ROI.
+// So với ROI xám (cùng ảnh) và với ROI BGR (đường cũ: crop BGR rồi cvtColor trong assessFaceQuality)
+#define QUALITY_TOL 1e-5f
+
+static void test_quality_gray() {
+    cv::RNG rng(4321);
+    FaceNet net;                    // Không cần nạp model cho quality
+    cv::Mat frame(240, 320, CV_8UC3), gray, noise(240, 320, CV_8UC3);
+    float worst = 0.0f;
+
+    for (int i = 0; i < 40; i++) {
+        int base = rng.uniform(10, 240), amp = rng.uniform(1, 10);
+        frame.setTo(cv::Scalar::all(base));
+        rng.fill(noise, cv::RNG::UNIFORM, 0, amp + 1);
+        frame += noise;
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+
+        int w = i < 2 ? 20 + i * 19 : rng.uniform(36, 200);    // 2 ROI đầu hẹp hơn 40 -> điểm 0
+        int h = rng.uniform(36, 200);
+        cv::Rect r(rng.uniform(1, frame.cols - w), rng.uniform(1, frame.rows - h), w, h);
+
+        cv::Mat roi_gray = gray(r);
+        float fast = face_quality_gray(roi_gray.data, roi_gray.cols, roi_gray.rows, roi_gray.step);
+        float ref_gray = net.checkQuality(roi_gray);
+        float ref_bgr = net.checkQuality(frame(r));
+
+        float diff = std::max(fabsf(fast - ref_gray), fabsf(fast - ref_bgr));
+        worst = std::max(worst, diff);
+        CHECK(diff <= QUALITY_TOL, "%dx%d at (%d,%d): fast %.7f, gray ref %.7f, bgr ref %.7f",
+              w, h, r.x, r.y, fast, ref_gray, ref_bgr);
+    }
+    printf("    40 ROIs, max |diff| %g\n", worst);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) filter = argv[1];
+
+    run("rgb565_kernels", test_rgb565_kernels);
+    run("yuyv_rgb565", test_yuyv_rgb565);
+    run("v4l2_fake_yuyv", test_v4l2_fake_yuyv);
+    run("lcd_pipeline_mock", test_lcd_pipeline_mock);
+    run("lcd_command_writes", test_lcd_command_writes);
+    run("overlay_offscreen", test_overlay_offscreen);
+    run("alloc_per_frame", test_alloc_per_frame);
+    run("preprocess_fused", test_preprocess_fused);
+    run("quality_gray", test_quality_gray);
+
+    if (failed_cases) printf("%d case(s) failed\n", failed_cases);
+    return failed_cases ? 1 : 0;
+}
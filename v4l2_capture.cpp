@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "v4l2_capture.h"
+
+static int xioctl(int fd, unsigned long req, void* arg) {
+    int r;
+    do {
+        r = ioctl(fd, req, arg);
+    } while (r < 0 && errno == EINTR);
+    return r;
+}
+
+static const char* format_name(uint32_t pixfmt) {
+    return pixfmt == V4L2_PIX_FMT_MJPEG ? "MJPEG" : "YUYV";
+}
+
+// Tìm từng ảnh JPEG (SOI FFD8 ... EOI FFD9) trong file MJPEG.
+// Dữ liệu entropy luôn chèn 00 sau FF nên FFD9 đầu tiên sau SOI là cuối ảnh (ảnh không kèm thumbnail EXIF)
+static int index_jpegs(V4l2Capture* c, const uint8_t* p, size_t n) {
+    size_t cap = 64;
+    c->jpeg_offsets = (size_t*)malloc(cap * sizeof(size_t));
+    c->jpeg_sizes = (size_t*)malloc(cap * sizeof(size_t));
+    if (!c->jpeg_offsets || !c->jpeg_sizes) return 0;
+
+    size_t i = 0;
+    while (i + 1 < n) {
+        if (!(p[i] == 0xFF && p[i + 1] == 0xD8)) { i++; continue; }
+        size_t j = i + 2;
+        while (j + 1 < n && !(p[j] == 0xFF && p[j + 1] == 0xD9)) j++;
+        if (j + 1 >= n) break;                  // Ảnh cuối bị cắt
+        if (c->n_frames == cap) {
+            cap *= 2;
+            size_t* o = (size_t*)realloc(c->jpeg_offsets, cap * sizeof(size_t));
+            if (o) c->jpeg_offsets = o;
+            size_t* z = (size_t*)realloc(c->jpeg_sizes, cap * sizeof(size_t));
+            if (z) c->jpeg_sizes = z;
+            if (!o || !z) return 0;
+        }
+        c->jpeg_offsets[c->n_frames] = i;
+        c->jpeg_sizes[c->n_frames] = j + 2 - i;
+        c->n_frames++;
+        i = j + 2;
+    }
+    return 1;
+}
+
+static int open_fake(V4l2Capture* c, const char* path, int width, int height) {
+    struct stat st;
+    if (fstat(c->fd, &st) != 0 || st.st_size == 0) return 0;
+    c->width = width;
+    c->height = height;
+    c->stride = (size_t)width * 2;
+    size_t frame_bytes = c->stride * height;
+    c->file_size = st.st_size;
+    if (c->pixfmt == V4L2_PIX_FMT_YUYV) {
+        c->n_frames = (size_t)st.st_size / frame_bytes;
+        c->file_size = c->n_frames * frame_bytes;
+    }
+    if (c->file_size == 0) {
+        printf("[V4L2] %s: smaller than one %dx%d YUYV frame\n", path, width, height);
+        return 0;
+    }
+    void* m = mmap(NULL, c->file_size, PROT_READ, MAP_PRIVATE, c->fd, 0);
+    if (m == MAP_FAILED) return 0;
+    c->file_map = (uint8_t*)m;
+    c->fake = 1;
+
+    if (c->pixfmt == V4L2_PIX_FMT_MJPEG) {
+        if (!index_jpegs(c, c->file_map, c->file_size)) return 0;
+        if (c->n_frames == 0) {
+            printf("[V4L2] %s: no JPEG frame found\n", path);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int open_device(V4l2Capture* c, const char* path, int width, int height, int fps) {
+    struct v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    if (xioctl(c->fd, VIDIOC_QUERYCAP, &cap) < 0 ||
+        !(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) || !(cap.capabilities & V4L2_CAP_STREAMING)) {
+        printf("[V4L2] %s: not a streaming capture device\n", path);
+        return 0;
+    }
+
+    struct v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = c->pixfmt;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(c->fd, VIDIOC_S_FMT, &fmt) < 0 || fmt.fmt.pix.pixelformat != c->pixfmt) {
+        printf("[V4L2] %s: %s not supported\n", path, format_name(c->pixfmt));
+        return 0;
+    }
+    c->width = fmt.fmt.pix.width;
+    c->height = fmt.fmt.pix.height;
+    c->stride = fmt.fmt.pix.bytesperline ? fmt.fmt.pix.bytesperline : (size_t)c->width * 2;
+
+    // FPS chỉ là yêu cầu, driver không hỗ trợ thì bỏ qua
+    struct v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = fps;
+    xioctl(c->fd, VIDIOC_S_PARM, &parm);
+
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = V4L2_BUFFERS;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(c->fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        printf("[V4L2] %s: REQBUFS failed: %s\n", path, strerror(errno));
+        return 0;
+    }
+    if (req.count > V4L2_BUFFERS) req.count = V4L2_BUFFERS;
+
+    for (uint32_t i = 0; i < req.count; i++) {
+        struct v4l2_buffer b;
+        memset(&b, 0, sizeof(b));
+        b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        b.memory = V4L2_MEMORY_MMAP;
+        b.index = i;
+        if (xioctl(c->fd, VIDIOC_QUERYBUF, &b) < 0) return 0;
+        void* m = mmap(NULL, b.length, PROT_READ | PROT_WRITE, MAP_SHARED, c->fd, b.m.offset);
+        if (m == MAP_FAILED) return 0;
+        c->bufs[i].start = m;
+        c->bufs[i].length = b.length;
+        c->n_bufs++;
+        if (xioctl(c->fd, VIDIOC_QBUF, &b) < 0) return 0;
+    }
+
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(c->fd, VIDIOC_STREAMON, &type) < 0) {
+        printf("[V4L2] %s: STREAMON failed: %s\n", path, strerror(errno));
+        return 0;
+    }
+    return 1;
+}
+
+int v4l2_capture_open(V4l2Capture* c, const char* path, int width, int height, int fps, uint32_t pixfmt) {
+    memset(c, 0, sizeof(*c));
+    c->held = -1;
+    c->pixfmt = pixfmt;
+    c->fd = open(path, O_RDWR | O_NONBLOCK);
+    if (c->fd < 0) {
+        printf("[V4L2] Cannot open %s: %s\n", path, strerror(errno));
+        return 0;
+    }
+
+    struct stat st;
+    int ok = fstat(c->fd, &st) == 0 && S_ISREG(st.st_mode) ? open_fake(c, path, width, height)
+                                                            : open_device(c, path, width, height, fps);
+    if (!ok) {
+        v4l2_capture_close(c);
+        return 0;
+    }
+    if (c->fake && c->pixfmt == V4L2_PIX_FMT_MJPEG) {
+        printf("[V4L2] %s: MJPEG, %zu frames (file)\n", path, c->n_frames);
+    } else {
+        printf("[V4L2] %s: %s %dx%d%s\n", path, format_name(c->pixfmt), c->width, c->height,
+               c->fake ? " (file)" : "");
+    }
+    return 1;
+}
+
+int v4l2_capture_next(V4l2Capture* c, const uint8_t** data, size_t* size, int timeout_ms) {
+    if (c->fake) {
+        if (c->next_frame >= c->n_frames) return 0;
+        size_t i = c->next_frame++;
+        if (c->pixfmt == V4L2_PIX_FMT_MJPEG) {
+            *data = c->file_map + c->jpeg_offsets[i];
+            *size = c->jpeg_sizes[i];
+        } else {
+            *size = c->stride * c->height;
+            *data = c->file_map + i * *size;
+        }
+        return 1;
+    }
+
+    struct v4l2_buffer b;
+    if (c->held >= 0) {
+        memset(&b, 0, sizeof(b));
+        b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        b.memory = V4L2_MEMORY_MMAP;
+        b.index = c->held;
+        c->held = -1;
+        if (xioctl(c->fd, VIDIOC_QBUF, &b) < 0) return 0;
+    }
+
+    struct pollfd pfd = { c->fd, POLLIN, 0 };
+    int r;
+    do {
+        r = poll(&pfd, 1, timeout_ms);
+    } while (r < 0 && errno == EINTR);
+    if (r == 0) return -1;
+    if (r < 0) return 0;
+
+    memset(&b, 0, sizeof(b));
+    b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    b.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(c->fd, VIDIOC_DQBUF, &b) < 0) return errno == EAGAIN ? -1 : 0;
+
+    // Frame lỗi (bit ERROR) hoặc thiếu dữ liệu -> trả lại ở lần gọi sau, coi như chưa có frame.
+    // MJPEG dài ngắn tùy nội dung, chỉ cần khác rỗng
+    c->held = b.index;
+    size_t need = c->pixfmt == V4L2_PIX_FMT_MJPEG ? 1 : c->stride * c->height;
+    if ((b.flags & V4L2_BUF_FLAG_ERROR) || b.bytesused < need) return -1;
+    *data = (const uint8_t*)c->bufs[b.index].start;
+    *size = b.bytesused;
+    return 1;
+}
+
+void v4l2_capture_rewind(V4l2Capture* c) {
+    c->next_frame = 0;
+}
+
+void v4l2_capture_close(V4l2Capture* c) {
+    if (!c->fake && c->n_bufs > 0) {
+        enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(c->fd, VIDIOC_STREAMOFF, &type);
+    }
+    for (int i = 0; i < c->n_bufs; i++) munmap(c->bufs[i].start, c->bufs[i].length);
+    if (c->file_map) munmap(c->file_map, c->file_size);
+    free(c->jpeg_offsets);
+    free(c->jpeg_sizes);
+    c->jpeg_offsets = c->jpeg_sizes = NULL;
+    if (c->fd >= 0) close(c->fd);
+    c->n_bufs = 0;
+    c->file_map = NULL;
+    c->fd = -1;
+    c->held = -1;
+}
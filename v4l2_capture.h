@@ -0,0 +1,47 @@
+#ifndef V4L2_CAPTURE_H
+#define V4L2_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/videodev2.h>
+#include "config.h"
+
+// Capture YUYV / MJPEG trực tiếp qua V4L2 với buffer mmap của driver (không decode, không copy trong kernel).
+// path là file thường -> thiết bị giả (test không cần camera; v4l2loopback thì dùng như camera thật):
+//   YUYV : file thô gồm các frame width x height nối tiếp
+//   MJPEG: các ảnh JPEG nối tiếp (ffmpeg -f mjpeg), tách theo marker SOI / EOI
+typedef struct {
+    void* start;
+    size_t length;
+} V4l2Buffer;
+
+typedef struct {
+    int fd;
+    int fake;                       // 1 = file thay cho camera
+    uint32_t pixfmt;                // V4L2_PIX_FMT_YUYV | V4L2_PIX_FMT_MJPEG
+    int width, height;
+    size_t stride;                  // Byte mỗi dòng (driver có thể đệm thêm), YUYV
+    V4l2Buffer bufs[V4L2_BUFFERS];
+    int n_bufs;
+    int held;                       // Buffer app đang giữ (-1 = không), trả lại ở lần lấy sau
+
+    // Thiết bị giả
+    uint8_t* file_map;
+    size_t file_size;
+    size_t n_frames;
+    size_t next_frame;
+    size_t* jpeg_offsets;           // MJPEG: vị trí + độ dài từng ảnh trong file
+    size_t* jpeg_sizes;
+} V4l2Capture;
+
+// Mở + cấu hình pixfmt (YUYV / MJPEG) width x height @fps và bắt đầu stream. Driver có thể chọn
+// kích thước khác (đọc lại c->width / c->height). Trả về 1 nếu thành công
+int  v4l2_capture_open(V4l2Capture* c, const char* path, int width, int height, int fps, uint32_t pixfmt);
+// Lấy frame tiếp theo: trả buffer đang giữ cho driver rồi chờ frame mới (tối đa timeout_ms).
+// 1 = có frame (*data, *size hợp lệ tới lần gọi sau), 0 = lỗi / hết file, -1 = hết thời gian chờ
+int  v4l2_capture_next(V4l2Capture* c, const uint8_t** data, size_t* size, int timeout_ms);
+// Thiết bị giả: quay lại frame đầu
+void v4l2_capture_rewind(V4l2Capture* c);
+void v4l2_capture_close(V4l2Capture* c);
+
+#endif